@@ -0,0 +1,80 @@
+#include "byte_stream.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using namespace std;
+using namespace std::chrono;
+
+constexpr size_t len = 256 * 1024 * 1024;
+constexpr size_t capacity = 64000;
+
+double gigabytes_per_second(const size_t bytes, const nanoseconds::rep duration) {
+    return double(bytes) / double(duration);
+}
+
+void benchmark_chunk_size(const size_t chunk_size) {
+    ByteStream stream{capacity};
+
+    string chunk(chunk_size, 'x');
+    for (auto &ch : chunk) {
+        ch = rand();
+    }
+
+    nanoseconds::rep write_time = 0, peek_time = 0, pop_time = 0;
+    size_t bytes_transferred = 0;
+    size_t checksum = 0;
+
+    while (bytes_transferred < len) {
+        // fill the stream
+        const auto t0 = high_resolution_clock::now();
+        while (stream.remaining_capacity() >= chunk_size) {
+            stream.write(chunk);
+        }
+        const auto t1 = high_resolution_clock::now();
+
+        // peek at the front of the stream once per chunk that was written
+        const size_t buffered = stream.buffer_size();
+        for (size_t i = 0; i < buffered; i += chunk_size) {
+            checksum += uint8_t(stream.peek_output(chunk_size).back());
+        }
+        const auto t2 = high_resolution_clock::now();
+
+        // drain the stream
+        while (not stream.buffer_empty()) {
+            stream.pop_output(chunk_size);
+        }
+        const auto t3 = high_resolution_clock::now();
+
+        bytes_transferred += buffered;
+        write_time += duration_cast<nanoseconds>(t1 - t0).count();
+        peek_time += duration_cast<nanoseconds>(t2 - t1).count();
+        pop_time += duration_cast<nanoseconds>(t3 - t2).count();
+    }
+
+    if (stream.bytes_read() != bytes_transferred or checksum == 0) {
+        throw runtime_error("bytes read vs. written don't match");
+    }
+
+    cout << fixed << setprecision(2);
+    cout << "chunk " << setw(6) << chunk_size << " bytes: write " << setw(7)
+         << gigabytes_per_second(bytes_transferred, write_time) << " GB/s, peek " << setw(7)
+         << gigabytes_per_second(bytes_transferred, peek_time) << " GB/s, pop " << setw(8)
+         << gigabytes_per_second(bytes_transferred, pop_time) << " GB/s\n";
+}
+
+int main() {
+    try {
+        for (const size_t chunk_size : {16, 128, 1452, 4096, 16384}) {
+            benchmark_chunk_size(chunk_size);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
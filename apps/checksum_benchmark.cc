@@ -0,0 +1,97 @@
+#include "util.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <utility>
+
+using namespace std;
+using namespace std::chrono;
+
+using Kernel = InternetChecksum::Kernel;
+
+constexpr size_t len = 256 * 1024 * 1024;
+
+double gigabytes_per_second(const size_t bytes, const nanoseconds::rep duration) {
+    return double(bytes) / double(duration);
+}
+
+//! The checksum as InternetChecksum::add computed it before the kernels: a byte at a time
+uint16_t bytewise_checksum(const string_view data) {
+    uint32_t sum = 0;
+    bool parity = false;
+    for (size_t i = 0; i < data.size(); i++) {
+        uint16_t val = uint8_t(data[i]);
+        if (not parity) {
+            val <<= 8;
+        }
+        sum += val;
+        parity = !parity;
+    }
+    while (sum > 0xffff) {
+        sum = (sum >> 16) + (sum & 0xffff);
+    }
+    return ~sum;
+}
+
+//! Checksum `payload` over and over, from an odd offset every other time, and return GB/s
+template <typename Checksum>
+double benchmark(const string &buffer, const size_t payload_size, uint16_t &result, Checksum &&checksum) {
+    const size_t iterations = len / payload_size;
+    uint32_t accumulated = 0;
+
+    const auto start = high_resolution_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        accumulated += checksum(string_view{buffer}.substr(i % 2, payload_size));
+    }
+    const auto end = high_resolution_clock::now();
+
+    result = static_cast<uint16_t>(accumulated);
+    return gigabytes_per_second(iterations * payload_size, duration_cast<nanoseconds>(end - start).count());
+}
+
+void benchmark_payload_size(const size_t payload_size) {
+    string buffer(payload_size + 1, 0);
+    for (auto &ch : buffer) {
+        ch = rand();
+    }
+
+    uint16_t expected = 0;
+    cout << fixed << setprecision(2) << "payload " << setw(5) << payload_size << " bytes: bytewise " << setw(6)
+         << benchmark(buffer, payload_size, expected, bytewise_checksum) << " GB/s";
+
+    const pair<Kernel, const char *> kernels[] = {
+        {Kernel::Portable, "portable"}, {Kernel::SSE2, "SSE2"}, {Kernel::AVX2, "AVX2"}};
+    for (const auto &[kernel, name] : kernels) {
+        if (not InternetChecksum::supported(kernel)) {
+            continue;
+        }
+        uint16_t result = 0;
+        const double rate = benchmark(buffer, payload_size, result, [kernel = kernel](const string_view data) {
+            InternetChecksum sum{0, kernel};
+            sum.add(data);
+            return sum.value();
+        });
+        if (result != expected) {
+            throw runtime_error(string{name} + " kernel disagrees with the bytewise checksum");
+        }
+        cout << ", " << name << " " << setw(6) << rate << " GB/s";
+    }
+    cout << "\n";
+}
+
+int main() {
+    try {
+        for (const size_t payload_size : {20, 64, 576, 1452, 9000, 65536}) {
+            benchmark_payload_size(payload_size);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
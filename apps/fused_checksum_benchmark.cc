@@ -0,0 +1,122 @@
+#include "byte_stream.hh"
+#include "stream_reassembler.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+constexpr size_t len = 256 * 1024 * 1024;
+constexpr size_t capacity = 256 * 1024;
+
+double gigabytes_per_second(const size_t bytes, const nanoseconds::rep duration) {
+    return double(bytes) / double(duration);
+}
+
+//! Sender: read each payload out of the stream, then sum it (two passes), or sum it as it is read (fused)
+double benchmark_send(const string &data, const size_t payload_size, const bool fused, uint16_t &result) {
+    ByteStream stream{capacity};
+    const size_t iterations = len / payload_size;
+    uint32_t accumulated = 0;
+
+    const auto start = high_resolution_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        stream.write(string_view{data}.substr(0, payload_size));
+        InternetChecksum sum;
+        if (fused) {
+            const BufferList payload = stream.read_buffers(payload_size, sum);
+        } else {
+            const BufferList payload = stream.read_buffers(payload_size);
+            for (const auto &buffer : payload.buffers()) {
+                sum.add(buffer.str());
+            }
+        }
+        accumulated += sum.value();
+    }
+    const auto end = high_resolution_clock::now();
+
+    result = static_cast<uint16_t>(accumulated);
+    return gigabytes_per_second(iterations * payload_size, duration_cast<nanoseconds>(end - start).count());
+}
+
+//! Receiver: verify each segment as it is parsed and then copy its payload into the stream (two
+//! passes), or verify it as the payload is copied (fused)
+double benchmark_receive(const string &data, const size_t payload_size, const bool fused) {
+    // the segments arrive in order; a few distinct ones are enough
+    vector<Buffer> wire;
+    for (size_t i = 0; i < 16; i++) {
+        TCPSegment seg;
+        seg.header().ack = true;
+        seg.payload() = data.substr(i % 2, payload_size);
+        wire.emplace_back(seg.serialize().concatenate());
+    }
+
+    StreamReassembler reassembler{capacity};
+    const size_t iterations = len / payload_size;
+
+    const auto start = high_resolution_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        TCPSegment seg;
+        if (seg.parse(wire[i % wire.size()], 0, fused) != ParseResult::NoError) {
+            throw runtime_error("segment did not parse");
+        }
+        const uint64_t index = reassembler.stream_out().bytes_written();
+        if (fused) {
+            if (not reassembler.push_substring(seg.payload(), index, false, seg.deferred_checksum().value())) {
+                throw runtime_error("segment failed its deferred checksum");
+            }
+        } else {
+            reassembler.push_substring(seg.payload(), index, false);
+        }
+        reassembler.stream_out().pop_output(payload_size);
+    }
+    const auto end = high_resolution_clock::now();
+
+    if (reassembler.stream_out().bytes_written() != iterations * payload_size) {
+        throw runtime_error("payload bytes went missing");
+    }
+    return gigabytes_per_second(iterations * payload_size, duration_cast<nanoseconds>(end - start).count());
+}
+
+void benchmark_payload_size(const size_t payload_size) {
+    string data(payload_size + 1, 0);
+    for (auto &ch : data) {
+        ch = rand();
+    }
+
+    uint16_t two_pass_result = 0;
+    uint16_t fused_result = 0;
+    const double send_two_pass = benchmark_send(data, payload_size, false, two_pass_result);
+    const double send_fused = benchmark_send(data, payload_size, true, fused_result);
+    if (two_pass_result != fused_result) {
+        throw runtime_error("fused read disagrees with read-then-sum");
+    }
+    const double receive_two_pass = benchmark_receive(data, payload_size, false);
+    const double receive_fused = benchmark_receive(data, payload_size, true);
+
+    cout << fixed << setprecision(2) << "payload " << setw(5) << payload_size << " bytes: send " << setw(6)
+         << send_two_pass << " -> " << setw(6) << send_fused << " GB/s, receive " << setw(6) << receive_two_pass
+         << " -> " << setw(6) << receive_fused << " GB/s\n";
+}
+
+int main() {
+    try {
+        cout << "two passes -> fused copy and checksum (" << len / (1024 * 1024) << " MiB each)\n";
+        for (const size_t payload_size : {64, 576, 1452, 9000, 65536}) {
+            benchmark_payload_size(payload_size);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,90 @@
+#include "tcp_over_ip.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <string_view>
+
+using namespace std;
+using namespace std::chrono;
+
+// Every heap allocation in the program is counted, as in segment_alloc_benchmark
+
+static size_t allocations = 0;
+
+void *operator new(size_t size) {
+    allocations++;
+    if (void *ptr = malloc(size)) {
+        return ptr;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { free(ptr); }
+
+void operator delete(void *ptr, size_t) noexcept { free(ptr); }
+
+constexpr size_t iterations = 4 * 1024 * 1024;
+
+//! An adapter that only builds datagrams
+class Wrapper : public TCPOverIPv4Adapter {
+  public:
+    Wrapper() {
+        config_mut().source = {"169.254.144.9", 1234};
+        config_mut().destination = {"169.254.144.1", 5678};
+    }
+};
+
+//! Build a datagram for `seg` over and over, and report the time and allocations per datagram
+template <typename Build>
+void benchmark(const string &name, TCPSegment &seg, Build &&build) {
+    size_t wire_bytes = 0;
+    const size_t start_allocations = allocations;
+    const auto start = high_resolution_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        seg.header().seqno = seg.header().seqno + seg.payload().size();
+        wire_bytes += build(seg);
+    }
+    const auto end = high_resolution_clock::now();
+    const size_t datagram_allocations = allocations - start_allocations;
+
+    if (wire_bytes <= iterations * seg.payload().size()) {
+        throw runtime_error("datagrams are missing their headers");
+    }
+
+    cout << fixed << setprecision(2) << name << ": " << setw(6)
+         << double(duration_cast<nanoseconds>(end - start).count()) / iterations << " ns and " << setw(4)
+         << double(datagram_allocations) / iterations << " allocations per datagram\n";
+}
+
+int main() {
+    try {
+        Wrapper wrapper;
+
+        // a data segment as TCPConnection sends it, with timestamps and a SACK block
+        TCPSegment seg;
+        seg.header().ack = true;
+        seg.header().win = 65535;
+        seg.header().timestamps = TCPHeader::Timestamps{123456, 654321};
+        seg.header().sack = {{WrappingInt32{1000}, WrappingInt32{2000}}};
+        seg.payload() = string(1452, 'x');
+        seg.sum_payload();
+
+        benchmark("string headers  ", seg, [&](TCPSegment &s) {
+            return wrapper.wrap_tcp_in_ip(s).serialize().size();
+        });
+        benchmark("headroom headers", seg, [&](TCPSegment &s) {
+            TCPOverIPv4Adapter::HeaderBuffer headers;
+            wrapper.prepend_tcp_in_ip_headers(s, headers);
+            return headers.size() + s.payload().size();
+        });
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,126 @@
+#include "tcp_connection.hh"
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Every heap allocation in the program is counted, so that the allocations of one stage of the
+// segment pipeline can be measured as the difference between two snapshots.
+
+static size_t allocations = 0;
+static size_t allocated_bytes = 0;
+
+void *operator new(size_t size) {
+    allocations++;
+    allocated_bytes += size;
+    if (void *ptr = malloc(size)) {
+        return ptr;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { free(ptr); }
+
+void operator delete(void *ptr, size_t) noexcept { free(ptr); }
+
+constexpr size_t rounds = 10000;
+constexpr size_t segments_per_round = 10;
+
+//! Heap activity between two points of the program
+struct AllocationCount {
+    size_t count{};
+    size_t bytes{};
+
+    void add_since(const AllocationCount &start) {
+        count += allocations - start.count;
+        bytes += allocated_bytes - start.bytes;
+    }
+
+    static AllocationCount now() { return {allocations, allocated_bytes}; }
+};
+
+//! Deliver all of `from`'s segments to `to`
+static void deliver(TCPConnection &from, TCPConnection &to) {
+    while (not from.segments_out().empty()) {
+        to.segment_received(from.segments_out().front());
+        from.segments_out().pop();
+    }
+}
+
+//! Counts the allocations on the way from TCPConnection::write to serialized segments, as an FD
+//! adapter would send them, and on the way back for the ACKs
+void benchmark(const string &name, const ByteStream::StorageMode storage) {
+    TCPConfig config;
+    config.send_storage = storage;
+    config.send_capacity = segments_per_round * TCPConfig::MAX_PAYLOAD_SIZE;
+    config.recv_capacity = 4 * config.send_capacity;
+    TCPConnection x{config}, y{config};
+
+    x.connect();
+    deliver(x, y);
+    deliver(y, x);
+    deliver(x, y);
+
+    AllocationCount send_path, ack_path;
+    size_t data_segments = 0;
+    size_t payload_bytes = 0;
+    size_t wire_bytes = 0;
+    vector<TCPSegment> in_flight;
+    in_flight.reserve(segments_per_round);
+
+    for (size_t round = 0; round < rounds; round++) {
+        string data(config.send_capacity, static_cast<char>('a' + round % 26));
+
+        // the sender and the connection, then the adapter's serialization
+        const auto start = AllocationCount::now();
+        x.write(move(data));
+        while (not x.segments_out().empty()) {
+            TCPSegment &seg = x.segments_out().front();
+            wire_bytes += seg.serialize().size();
+            data_segments++;
+            payload_bytes += seg.payload().size();
+            in_flight.push_back(move(seg));
+            x.segments_out().pop();
+        }
+        send_path.add_since(start);
+
+        for (auto &seg : in_flight) {
+            y.segment_received(seg);
+        }
+        in_flight.clear();
+        y.inbound_stream().pop_output(y.inbound_stream().buffer_size());
+
+        // the ACKs back to the sender
+        const auto ack_start = AllocationCount::now();
+        deliver(y, x);
+        ack_path.add_since(ack_start);
+    }
+
+    if (payload_bytes != rounds * config.send_capacity or wire_bytes <= payload_bytes) {
+        throw runtime_error("not everything was sent");
+    }
+
+    cout << fixed << setprecision(2) << name << ": " << setw(6) << double(send_path.count) / data_segments
+         << " allocations and " << setw(7) << double(send_path.bytes) / data_segments
+         << " heap bytes per data segment sent, " << setw(5) << double(ack_path.count) / data_segments
+         << " allocations per segment acknowledged\n";
+}
+
+int main() {
+    try {
+        benchmark("ring stream ", ByteStream::StorageMode::Ring);
+        benchmark("chunk stream", ByteStream::StorageMode::Chunks);
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,86 @@
+#include "stream_reassembler.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+constexpr size_t num_segments = 100000;
+constexpr size_t max_segment_len = 1452;
+
+//! Push every segment (in the given order) into a fresh reassembler and check the result
+void push_segments(const string &description,
+                   const StreamReassembler::StorageMode mode,
+                   const string &data,
+                   const vector<tuple<size_t, size_t>> &segments) {
+    StreamReassembler reassembler{data.size(), mode};
+
+    const auto first_time = high_resolution_clock::now();
+
+    for (const auto &[offset, size] : segments) {
+        reassembler.push_substring(data.substr(offset, size), offset, offset + size == data.size());
+    }
+
+    const auto final_time = high_resolution_clock::now();
+
+    if (reassembler.stream_out().read(data.size()) != data or not reassembler.stream_out().eof()) {
+        throw runtime_error("strings pushed vs. reassembled don't match");
+    }
+
+    const auto duration = duration_cast<nanoseconds>(final_time - first_time).count();
+
+    cout << fixed << setprecision(2);
+    cout << (mode == StreamReassembler::StorageMode::Slab ? "slab,      " : "fragments, ") << description << ": "
+         << setw(8) << segments.size() * 1000.0 / double(duration) << " M segments/s, " << setw(6)
+         << data.size() * 8.0 / double(duration) << " Gbit/s\n";
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        vector<tuple<size_t, size_t>> segments;
+        size_t offset = 0;
+        for (size_t i = 0; i < num_segments; ++i) {
+            const size_t size = 1 + (rd() % max_segment_len);
+            segments.emplace_back(offset, size);
+            offset += size;
+        }
+
+        string data(offset, 0);
+        generate(data.begin(), data.end(), [&] { return rd(); });
+
+        vector<tuple<size_t, size_t>> reversed(segments.rbegin(), segments.rend());
+
+        vector<tuple<size_t, size_t>> permuted = segments;
+        shuffle(permuted.begin(), permuted.end(), rd);
+
+        // every byte arrives twice, in segments that straddle the original boundaries
+        vector<tuple<size_t, size_t>> overlapping = segments;
+        for (const auto &[seg_offset, size] : segments) {
+            const size_t shifted = min(seg_offset + size / 2, data.size() - 1);
+            overlapping.emplace_back(shifted, min(size, data.size() - shifted));
+        }
+        shuffle(overlapping.begin(), overlapping.end(), rd);
+
+        for (const auto mode : {StreamReassembler::StorageMode::Fragments, StreamReassembler::StorageMode::Slab}) {
+            push_segments("in order          ", mode, data, segments);
+            push_segments("reversed          ", mode, data, reversed);
+            push_segments("randomly permuted ", mode, data, permuted);
+            push_segments("permuted, overlaps", mode, data, overlapping);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -2,9 +2,11 @@
 
 #include <chrono>
 #include <cstdlib>
+#include <deque>
 #include <iomanip>
 #include <iostream>
 #include <string>
+#include <utility>
 
 using namespace std;
 using namespace std::chrono;
@@ -103,8 +105,331 @@ void main_loop(const bool reorder) {
     }
 }
 
-int main() {
+//! Serialize the segments x sends and parse them at y, as an FD adapter and the network would,
+//! splitting large segments into MSS-sized pieces as the adapters do
+void move_serialized_segments(TCPConnection &x, TCPConnection &y) {
+    while (not x.segments_out().empty()) {
+        for (const TCPSegment &piece : x.segments_out().front().split(TCPConfig::MAX_PAYLOAD_SIZE)) {
+            TCPSegment parsed;
+            if (parsed.parse(piece.serialize().concatenate()) != ParseResult::NoError) {
+                throw runtime_error("segment did not parse");
+            }
+            y.segment_received(move(parsed));
+        }
+        x.segments_out().pop();
+    }
+}
+
+//! Throughput when every segment is serialized and parsed, with and without segmentation offload
+void offload_loop(const bool offload) {
+    TCPConfig config;
+    config.segmentation_offload = offload;
+    TCPConnection x{config}, y{config};
+
+    string string_to_send(len, 'x');
+    for (auto &ch : string_to_send) {
+        ch = rand();
+    }
+
+    Buffer bytes_to_send{string(string_to_send)};
+    x.connect();
+    y.end_input_stream();
+
+    bool x_closed = false;
+
+    string string_received;
+    string_received.reserve(len);
+
+    const auto first_time = high_resolution_clock::now();
+
+    while (not y.inbound_stream().eof()) {
+        while (bytes_to_send.size() and x.remaining_outbound_capacity()) {
+            const auto want = min(x.remaining_outbound_capacity(), bytes_to_send.size());
+            bytes_to_send.remove_prefix(x.write(string(bytes_to_send.str().substr(0, want))));
+        }
+        if (bytes_to_send.size() == 0 and not x_closed) {
+            x.end_input_stream();
+            x_closed = true;
+        }
+
+        move_serialized_segments(x, y);
+        move_serialized_segments(y, x);
+
+        const auto available_output = y.inbound_stream().buffer_size();
+        if (available_output > 0) {
+            string_received.append(y.inbound_stream().read(available_output));
+        }
+
+        // time passes, but never as much as a retransmission timeout
+        x.tick(1);
+        y.tick(1);
+    }
+
+    if (string_received != string_to_send) {
+        throw runtime_error("strings sent vs. received don't match");
+    }
+
+    const auto duration = duration_cast<nanoseconds>(high_resolution_clock::now() - first_time).count();
+    cout << fixed << setprecision(2);
+    cout << "Serialized throughput, " << (offload ? "segmentation offload: " : "MSS-sized segments:   ")
+         << len * 8.0 / double(duration) << " Gbit/s\n";
+
+    while (x.active() or y.active()) {
+        move_serialized_segments(x, y);
+        move_serialized_segments(y, x);
+        x.tick(1);
+        y.tick(1);
+    }
+}
+
+//! A link that delivers segments a fixed time after they are sent
+class DelayLine {
+    uint64_t _delay;
+    deque<pair<uint64_t, TCPSegment>> _in_transit{};
+
+  public:
+    explicit DelayLine(const uint64_t delay) : _delay(delay) {}
+
+    void send(TCPSegment &&seg, const uint64_t now) { _in_transit.emplace_back(now + _delay, move(seg)); }
+
+    void deliver(TCPConnection &to, const uint64_t now) {
+        while (not _in_transit.empty() and _in_transit.front().first <= now) {
+            to.segment_received(move(_in_transit.front().second));
+            _in_transit.pop_front();
+        }
+    }
+};
+
+//! A fixed-rate bottleneck link fed by a drop-tail queue, followed by a propagation delay
+class Bottleneck {
+    static constexpr size_t HEADER_SIZE = 40;  // IPv4 and TCP headers without options
+
+    double _rate;          // bytes per ms
+    size_t _queue_limit;   // bytes
+    deque<TCPSegment> _queue{};
+    size_t _queued_bytes{0};
+    double _credit{0};
+    DelayLine _link;
+
+    static size_t wire_size(const TCPSegment &seg) { return seg.payload().size() + HEADER_SIZE; }
+
+  public:
+    uint64_t dropped{0};
+    uint64_t queue_samples{0};
+    uint64_t queue_total{0};
+
+    Bottleneck(const double rate, const size_t queue_limit, const uint64_t delay)
+        : _rate(rate), _queue_limit(queue_limit), _link(delay) {}
+
+    void send(TCPSegment &&seg) {
+        if (_queued_bytes + wire_size(seg) > _queue_limit) {
+            dropped++;
+            return;
+        }
+        _queued_bytes += wire_size(seg);
+        _queue.push_back(move(seg));
+    }
+
+    //! Serve the queue for one millisecond, then deliver what has crossed the link
+    void tick(TCPConnection &to, const uint64_t now) {
+        queue_samples++;
+        queue_total += _queued_bytes;
+
+        _credit += _rate;
+        while (not _queue.empty() and _credit >= wire_size(_queue.front())) {
+            _credit -= wire_size(_queue.front());
+            _queued_bytes -= wire_size(_queue.front());
+            _link.send(move(_queue.front()), now);
+            _queue.pop_front();
+        }
+        // an idle link cannot save up capacity
+        if (_queue.empty()) {
+            _credit = 0;
+        }
+
+        _link.deliver(to, now);
+    }
+
+    double mean_queueing_delay() const { return double(queue_total) / double(queue_samples) / _rate; }
+};
+
+//! Send data from x to y through a 10 Mbit/s bottleneck with a 40 ms round trip and a one-BDP queue
+void bottleneck_loop(const string &name, const CongestionController::Algorithm algorithm) {
+    constexpr size_t bottleneck_len = 8 * 1024 * 1024;
+    constexpr double rate = 1250;  // bytes per ms
+    constexpr uint64_t one_way_delay = 20;
+    constexpr size_t queue_limit = 50000;
+    constexpr uint64_t time_limit = 600 * 1000;
+
+    TCPConfig config;
+    config.recv_capacity = 256 * 1024;
+    config.send_capacity = 256 * 1024;
+    config.window_scaling = true;
+    config.sack = true;
+    config.congestion_control = algorithm;
+    TCPConnection x{config}, y{config};
+
+    Bottleneck forward{rate, queue_limit, one_way_delay};
+    DelayLine reverse{one_way_delay};
+
+    string string_to_send(bottleneck_len, 'x');
+    for (auto &ch : string_to_send) {
+        ch = rand();
+    }
+    size_t bytes_sent = 0;
+
+    string string_received;
+    string_received.reserve(bottleneck_len);
+
+    x.connect();
+    y.end_input_stream();
+
+    uint64_t now = 0;
+    auto loop = [&] {
+        if (now > time_limit) {
+            throw runtime_error(name + ": transfer did not finish");
+        }
+
+        if (bytes_sent < bottleneck_len) {
+            bytes_sent += x.write(string_to_send.substr(bytes_sent, x.remaining_outbound_capacity()));
+            if (bytes_sent == bottleneck_len) {
+                x.end_input_stream();
+            }
+        }
+
+        while (not x.segments_out().empty()) {
+            forward.send(move(x.segments_out().front()));
+            x.segments_out().pop();
+        }
+        while (not y.segments_out().empty()) {
+            reverse.send(move(y.segments_out().front()), now);
+            y.segments_out().pop();
+        }
+
+        forward.tick(y, now);
+        reverse.deliver(x, now);
+
+        string_received.append(y.inbound_stream().read(y.inbound_stream().buffer_size()));
+
+        x.tick(1);
+        y.tick(1);
+        now++;
+    };
+
+    while (not y.inbound_stream().eof()) {
+        loop();
+    }
+    const uint64_t transfer_time = now;
+
+    if (string_received != string_to_send) {
+        throw runtime_error(name + ": strings sent vs. received don't match");
+    }
+
+    cout << fixed << setprecision(2);
+    cout << setw(8) << name << ": " << setw(5) << bottleneck_len * 8.0 / double(transfer_time) / 1000 << " Mbit/s, "
+         << setw(5) << forward.dropped << " segments dropped, " << setw(6) << forward.mean_queueing_delay()
+         << " ms mean queueing delay\n";
+
+    while (x.active() or y.active()) {
+        loop();
+    }
+}
+
+//! Send a 100-byte message from x to y every millisecond over a 20 ms round trip, counting segments
+void interactive_loop(const string &name, const bool nodelay, const bool delayed_ack) {
+    constexpr size_t message_size = 100;
+    constexpr uint64_t messages = 5000;
+    constexpr uint64_t one_way_delay = 10;
+
+    TCPConfig config;
+    config.nodelay = nodelay;
+    config.delayed_ack = delayed_ack;
+    TCPConnection x{config}, y{config};
+
+    DelayLine forward{one_way_delay};
+    DelayLine reverse{one_way_delay};
+    uint64_t forward_segments = 0;
+    uint64_t reverse_segments = 0;
+
+    const string message(message_size, 'x');
+    size_t bytes_received = 0;
+
+    x.connect();
+    y.end_input_stream();
+
+    uint64_t now = 0;
+    auto loop = [&] {
+        if (now < messages and x.write(message) != message_size) {
+            throw runtime_error(name + ": message did not fit");
+        }
+        if (now == messages) {
+            x.end_input_stream();
+        }
+
+        while (not x.segments_out().empty()) {
+            forward.send(move(x.segments_out().front()), now);
+            x.segments_out().pop();
+            forward_segments++;
+        }
+        while (not y.segments_out().empty()) {
+            reverse.send(move(y.segments_out().front()), now);
+            y.segments_out().pop();
+            reverse_segments++;
+        }
+
+        forward.deliver(y, now);
+        reverse.deliver(x, now);
+
+        bytes_received += y.inbound_stream().read(y.inbound_stream().buffer_size()).size();
+
+        x.tick(1);
+        y.tick(1);
+        now++;
+    };
+
+    while (not y.inbound_stream().eof()) {
+        loop();
+    }
+    const uint64_t transfer_time = now;
+
+    if (bytes_received != messages * message_size) {
+        throw runtime_error(name + ": bytes sent vs. received don't match");
+    }
+
+    cout << setw(14) << name << ": " << setw(5) << forward_segments << " segments sent, " << setw(5)
+         << reverse_segments << " received, " << setw(5) << forward_segments + reverse_segments << " total in "
+         << transfer_time << " ms\n";
+
+    while (x.active() or y.active()) {
+        loop();
+    }
+}
+
+int main(int argc, char *argv[]) {
     try {
+        if (argc > 1 and string(argv[1]) == "bottleneck") {
+            bottleneck_loop("none", CongestionController::Algorithm::None);
+            bottleneck_loop("reno", CongestionController::Algorithm::Reno);
+            bottleneck_loop("newreno", CongestionController::Algorithm::NewReno);
+            bottleneck_loop("cubic", CongestionController::Algorithm::Cubic);
+            bottleneck_loop("bbr", CongestionController::Algorithm::BBR);
+            return EXIT_SUCCESS;
+        }
+
+        if (argc > 1 and string(argv[1]) == "interactive") {
+            interactive_loop("nodelay", true, false);
+            interactive_loop("nagle", false, false);
+            interactive_loop("delayed ack", true, true);
+            interactive_loop("nagle+delayed", false, true);
+            return EXIT_SUCCESS;
+        }
+
+        if (argc > 1 and string(argv[1]) == "offload") {
+            offload_loop(false);
+            offload_loop(true);
+            return EXIT_SUCCESS;
+        }
+
         main_loop(false);
         main_loop(true);
     } catch (const exception &e) {
@@ -7,6 +7,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <limits>
 #include <random>
 #include <string>
 #include <tuple>
@@ -78,6 +79,7 @@ static tuple<TCPConfig, FdAdapterConfig, Address, string> get_config(int argc, c
         } else if (strncmp("-w", argv[curr], 3) == 0) {
             check_argc(argc, argv, curr, "ERROR: -w requires one argument.");
             c_fsm.recv_capacity = strtol(argv[curr + 1], nullptr, 0);
+            c_fsm.window_scaling = c_fsm.recv_capacity > numeric_limits<uint16_t>::max();
             curr += 2;
 
         } else if (strncmp("-t", argv[curr], 3) == 0) {
@@ -7,12 +7,19 @@ add_test(NAME t_wrapping_ints_unwrap      COMMAND wrapping_integers_unwrap)
 add_test(NAME t_wrapping_ints_wrap        COMMAND wrapping_integers_wrap)
 add_test(NAME t_wrapping_ints_roundtrip   COMMAND wrapping_integers_roundtrip)
 
+add_test(NAME t_wrap_tcp_in_ip            COMMAND wrap_tcp_in_ip)
+add_test(NAME t_internet_checksum         COMMAND internet_checksum)
+add_test(NAME t_fused_checksum            COMMAND fused_checksum)
+add_test(NAME t_header_serialize          COMMAND header_serialize)
+
 add_test(NAME t_recv_connect         COMMAND recv_connect)
 add_test(NAME t_recv_transmit        COMMAND recv_transmit)
 add_test(NAME t_recv_window          COMMAND recv_window)
 add_test(NAME t_recv_reorder         COMMAND recv_reorder)
 add_test(NAME t_recv_close           COMMAND recv_close)
 add_test(NAME t_recv_special         COMMAND recv_special)
+add_test(NAME t_recv_sack            COMMAND recv_sack)
+add_test(NAME t_recv_offload         COMMAND recv_offload)
 
 add_test(NAME t_send_connect         COMMAND send_connect)
 add_test(NAME t_send_transmit        COMMAND send_transmit)
@@ -21,6 +28,15 @@ add_test(NAME t_send_window          COMMAND send_window)
 add_test(NAME t_send_ack             COMMAND send_ack)
 add_test(NAME t_send_close           COMMAND send_close)
 add_test(NAME t_send_extra           COMMAND send_extra)
+add_test(NAME t_send_sack            COMMAND send_sack)
+add_test(NAME t_send_congestion      COMMAND send_congestion)
+add_test(NAME t_send_pacing          COMMAND send_pacing)
+add_test(NAME t_send_rtt             COMMAND send_rtt)
+add_test(NAME t_send_fast_retransmit COMMAND send_fast_retransmit)
+add_test(NAME t_send_nagle           COMMAND send_nagle)
+add_test(NAME t_send_offload         COMMAND send_offload)
+add_test(NAME t_send_partial_ack     COMMAND send_partial_ack)
+add_test(NAME t_send_rack            COMMAND send_rack)
 
 add_test(NAME t_strm_reassem_single      COMMAND fsm_stream_reassembler_single)
 add_test(NAME t_strm_reassem_seq         COMMAND fsm_stream_reassembler_seq)
@@ -30,6 +46,7 @@ add_test(NAME t_strm_reassem_many        COMMAND fsm_stream_reassembler_many)
 add_test(NAME t_strm_reassem_overlapping COMMAND fsm_stream_reassembler_overlapping)
 add_test(NAME t_strm_reassem_win         COMMAND fsm_stream_reassembler_win)
 add_test(NAME t_strm_reassem_cap         COMMAND fsm_stream_reassembler_cap)
+add_test(NAME t_strm_reassem_accounting  COMMAND fsm_stream_reassembler_accounting)
 
 add_test(NAME t_byte_stream_construction COMMAND byte_stream_construction)
 add_test(NAME t_byte_stream_one_write    COMMAND byte_stream_one_write)
@@ -52,6 +69,9 @@ add_test(NAME t_ack_rst_win          COMMAND fsm_ack_rst_win_relaxed)
 add_test(NAME t_connect              COMMAND fsm_connect_relaxed)
 add_test(NAME t_listen               COMMAND fsm_listen_relaxed)
 add_test(NAME t_winsize              COMMAND fsm_winsize)
+add_test(NAME t_winscale             COMMAND fsm_winscale)
+add_test(NAME t_timestamps           COMMAND fsm_timestamps)
+add_test(NAME t_delayed_ack          COMMAND fsm_delayed_ack)
 add_test(NAME t_retx                 COMMAND fsm_retx_relaxed)
 add_test(NAME t_retx_win             COMMAND fsm_retx_win)
 add_test(NAME t_loopback             COMMAND fsm_loopback)
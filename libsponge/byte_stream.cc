@@ -1,43 +1,182 @@
 #include "byte_stream.hh"
 
-// Dummy implementation of a flow-controlled in-memory byte stream.
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
 
-// For Lab 0, please replace with a real implementation that passes the
-// automated checks run by `make check_lab0`.
-
-// You will need to add private members to the class declaration in `byte_stream.hh`
+// Flow-controlled in-memory byte stream, stored either in a ring or as a queue of chunks.
 
 using namespace std;
 
-ByteStream::ByteStream(const size_t capacity) { _buffer.resize(capacity); }
+//! \returns the smallest power of two that is at least `n` (and at least one)
+static size_t round_up_pow2(const size_t n) {
+    size_t ret = 1;
+    while (ret < n) {
+        ret <<= 1;
+    }
+    return ret;
+}
+
+//! \param[in] capacity the maximum number of bytes the stream holds at once
+//! \param[in] mode whether to copy into a ring or to keep the written chunks
+ByteStream::ByteStream(const size_t capacity, const StorageMode mode)
+    : _mode(mode)
+    , _buffer(mode == StorageMode::Ring ? round_up_pow2(capacity) : 0)
+    , _mask(_buffer.size() - 1)
+    , _capacity(capacity) {}
+
+size_t ByteStream::write(const string &data) { return write(string_view(data)); }
+
+size_t ByteStream::write(const string_view data) {
+    _staged = 0;
+    if (_mode == StorageMode::Chunks) {
+        return write(string(data.substr(0, remaining_capacity())));
+    }
+
+    const size_t len = min(data.size(), remaining_capacity());
+    const size_t offset = _write_count & _mask;
+    const size_t first = min(len, _buffer.size() - offset);
+
+    memcpy(_buffer.data() + offset, data.data(), first);
+    memcpy(_buffer.data(), data.data() + first, len - first);
+
+    _write_count += len;
+    return len;
+}
+
+size_t ByteStream::write(string &&data) {
+    _staged = 0;
+    if (_mode == StorageMode::Ring) {
+        return write(string_view(data));
+    }
+
+    const size_t len = min(data.size(), remaining_capacity());
+    if (len == 0) {
+        return 0;
+    }
+
+    data.resize(len);
+    _chunks.emplace_back(move(data));
+
+    _write_count += len;
+    return len;
+}
+
+size_t ByteStream::write(const Buffer &data) {
+    _staged = 0;
+    if (_mode == StorageMode::Ring) {
+        return write(data.str());
+    }
 
-size_t ByteStream::write(const string &data) {
-    unsigned int i = 0;
-    for (; buffer_size() + i < _buffer.size() && i < data.size(); ++i) {
-        _buffer[(_end + i) % _buffer.size()] = data[i];
+    const size_t len = min(data.size(), remaining_capacity());
+    if (len == 0) {
+        return 0;
     }
 
-    _end = (_end + i) % _buffer.size();
-    _write_count += i;
-    _size += i;
+    Buffer chunk = data;
+    chunk.remove_suffix(data.size() - len);
+    _chunks.push_back(move(chunk));
 
-    return i;
+    _write_count += len;
+    return len;
+}
+
+//! \param[in] data the bytes to stage, which must fit in the remaining capacity
+//! \param[in,out] checksum the checksum to add `data` to
+//! \details The free space of the ring starts at the first slot after the written bytes, so the
+//! staged bytes are invisible to readers until commit() counts them as written.
+void ByteStream::stage(const Buffer &data, InternetChecksum &checksum) {
+    if (data.size() > remaining_capacity()) {
+        throw runtime_error("ByteStream::stage: data does not fit in the remaining capacity");
+    }
+    _staged = data.size();
+
+    if (_mode == StorageMode::Chunks) {
+        checksum.add(data.str());
+        _staged_chunk = data;
+        return;
+    }
+
+    const size_t offset = _write_count & _mask;
+    const size_t first = min(data.size(), _buffer.size() - offset);
+
+    checksum.add_copy(_buffer.data() + offset, data.str().substr(0, first));
+    if (first < data.size()) {
+        checksum.add_copy(_buffer.data(), data.str().substr(first));
+    }
+}
+
+void ByteStream::commit() {
+    if (_mode == StorageMode::Chunks and _staged > 0) {
+        _chunks.push_back(move(_staged_chunk));
+        _staged_chunk = Buffer{};
+    }
+    _write_count += _staged;
+    _staged = 0;
 }
 
 //! \param[in] len bytes will be copied from the output side of the buffer
 string ByteStream::peek_output(const size_t len) const {
-    string output{};
-    for (unsigned int i = 0; i < min(len, buffer_size()); ++i) {
-        output += _buffer[(_start + i) % _buffer.size()];
+    const size_t n = min(len, buffer_size());
+
+    string output;
+    output.reserve(n);
+
+    if (_mode == StorageMode::Chunks) {
+        for (auto it = _chunks.begin(); output.size() < n; ++it) {
+            output.append(it->str().substr(0, n - output.size()));
+        }
+        return output;
     }
+
+    const size_t offset = _read_count & _mask;
+    const size_t first = min(n, _buffer.size() - offset);
+
+    output.append(_buffer.data() + offset, first);
+    output.append(_buffer.data(), n - first);
     return output;
 }
 
+//! \param[in] len bytes will be viewed from the output side of the buffer
+BufferViewList ByteStream::peek_views(const size_t len) const {
+    size_t n = min(len, buffer_size());
+
+    BufferViewList views;
+
+    if (_mode == StorageMode::Chunks) {
+        for (auto it = _chunks.begin(); n > 0; ++it) {
+            const string_view view = it->str().substr(0, n);
+            views.append(view);
+            n -= view.size();
+        }
+        return views;
+    }
+
+    const size_t offset = _read_count & _mask;
+    const size_t first = min(n, _buffer.size() - offset);
+
+    views.append({_buffer.data() + offset, first});
+    views.append({_buffer.data(), n - first});
+    return views;
+}
+
 //! \param[in] len bytes will be removed from the output side of the buffer
 void ByteStream::pop_output(const size_t len) {
-    _start = (_start + min(len, _size)) % _buffer.size();
-    _read_count += min(len, _size);
-    _size -= min(len, _size);
+    const size_t n = min(len, buffer_size());
+    _read_count += n;
+
+    if (_mode == StorageMode::Chunks) {
+        size_t remaining = n;
+        while (remaining > 0) {
+            if (remaining < _chunks.front().size()) {
+                _chunks.front().remove_prefix(remaining);
+                remaining = 0;
+            } else {
+                remaining -= _chunks.front().size();
+                _chunks.pop_front();
+            }
+        }
+    }
 }
 
 //! Read (i.e., copy and then pop) the next "len" bytes of the stream
@@ -49,11 +188,66 @@ std::string ByteStream::read(const size_t len) {
     return output;
 }
 
+//! \param[in] len bytes will be popped and returned
+//! \details The ring's storage is reused by later writes, so it cannot be shared;
+//! in StorageMode::Ring the bytes are copied once into a single Buffer. In
+//! StorageMode::Chunks the returned Buffers share the written strings.
+BufferList ByteStream::read_buffers(const size_t len) {
+    if (_mode == StorageMode::Ring) {
+        return BufferList{read(len)};
+    }
+
+    size_t remaining = min(len, buffer_size());
+    _read_count += remaining;
+
+    BufferList output;
+    while (remaining > 0) {
+        if (remaining < _chunks.front().size()) {
+            Buffer head = _chunks.front();
+            head.remove_suffix(head.size() - remaining);
+            output.append(move(head));
+            _chunks.front().remove_prefix(remaining);
+            remaining = 0;
+        } else {
+            remaining -= _chunks.front().size();
+            output.append(move(_chunks.front()));
+            _chunks.pop_front();
+        }
+    }
+    return output;
+}
+
+//! \param[in] len bytes will be popped and returned
+//! \param[in,out] checksum the checksum to add the bytes to, in order
+//! \details In StorageMode::Ring the bytes are summed as they are copied out of the ring, so they
+//! are read once; in StorageMode::Chunks nothing is copied, and the shared Buffers are summed.
+BufferList ByteStream::read_buffers(const size_t len, InternetChecksum &checksum) {
+    if (_mode == StorageMode::Chunks) {
+        BufferList output = read_buffers(len);
+        for (const auto &buffer : output.buffers()) {
+            checksum.add(buffer.str());
+        }
+        return output;
+    }
+
+    const size_t n = min(len, buffer_size());
+    const size_t offset = _read_count & _mask;
+    const size_t first = min(n, _buffer.size() - offset);
+
+    string output(n, 0);
+    checksum.add_copy(output.data(), {_buffer.data() + offset, first});
+    if (first < n) {
+        checksum.add_copy(output.data() + first, {_buffer.data(), n - first});
+    }
+    _read_count += n;
+    return BufferList{move(output)};
+}
+
 void ByteStream::end_input() { _input_end = true; }
 
 bool ByteStream::input_ended() const { return _input_end; }
 
-size_t ByteStream::buffer_size() const { return _size; }
+size_t ByteStream::buffer_size() const { return _write_count - _read_count; }
 
 bool ByteStream::buffer_empty() const { return buffer_size() == 0; }
 
@@ -63,4 +257,4 @@ size_t ByteStream::bytes_written() const { return _write_count; }
 
 size_t ByteStream::bytes_read() const { return _read_count; }
 
-size_t ByteStream::remaining_capacity() const { return _buffer.size() - buffer_size(); }
+size_t ByteStream::remaining_capacity() const { return _capacity - buffer_size(); }
@@ -1,30 +1,62 @@
 #ifndef SPONGE_LIBSPONGE_BYTE_STREAM_HH
 #define SPONGE_LIBSPONGE_BYTE_STREAM_HH
 
+#include "buffer.hh"
+#include "util.hh"
+
+#include <cstddef>
+#include <deque>
 #include <string>
+#include <string_view>
+#include <vector>
 
 //! \brief An in-order byte stream.
 
 //! Bytes are written on the "input" side and read from the "output"
 //! side.  The byte stream is finite: the writer can end the input,
 //! and then no more bytes can be written.
+//!
+//! By default the bytes are kept in a ring whose storage is rounded up to a
+//! power of two, so a position in the stream maps to a slot with a mask instead
+//! of a modulo, and every write or peek is at most two contiguous `memcpy` spans.
+//!
+//! Alternatively, the stream can keep the written strings themselves as a queue
+//! of refcounted Buffers (see StorageMode::Chunks). A string moved into
+//! write() is then stored without a copy, and read_buffers() hands out
+//! slices of the same storage.
+//!
+//! Bytes that are checksummed on their way in or out can be summed while they are copied
+//! (see InternetChecksum::add_copy): stage() and commit() write bytes that only count once
+//! their checksum is verified, and read_buffers() can sum what it reads.
 class ByteStream {
+  public:
+    //! How the stream stores the bytes it holds
+    enum class StorageMode {
+        Ring,   //!< Copy into a preallocated power-of-two ring
+        Chunks  //!< Keep a queue of the written strings, shared with readers
+    };
+
   private:
-    std::string _buffer{};
-    size_t _start{};
-    size_t _end{};
-    size_t _size{};
+    StorageMode _mode;
+
+    std::vector<char> _buffer;     //!< Ring storage, size is a power of two (StorageMode::Ring only)
+    size_t _mask;                  //!< `_buffer.size() - 1`
+    std::deque<Buffer> _chunks{};  //!< Queue of written chunks (StorageMode::Chunks only)
+    size_t _capacity;              //!< Number of bytes the stream may hold
 
     bool _input_end{};
 
-    long _write_count{};
-    long _read_count{};
+    size_t _write_count{};  //!< Absolute index one past the last byte written
+    size_t _read_count{};   //!< Absolute index of the first byte not yet popped
 
     bool _error{};  //!< Flag indicating that the stream suffered an error.
 
+    size_t _staged{};         //!< Number of bytes staged by stage() and not yet committed
+    Buffer _staged_chunk{};  //!< The staged bytes (StorageMode::Chunks only)
+
   public:
     //! Construct a stream with room for `capacity` bytes.
-    ByteStream(const size_t capacity);
+    ByteStream(const size_t capacity, const StorageMode mode = StorageMode::Ring);
 
     //! \name "Input" interface for the writer
     //!@{
@@ -34,6 +66,28 @@ class ByteStream {
     //! \returns the number of bytes accepted into the stream
     size_t write(const std::string &data);
 
+    //! Write a view of bytes into the stream (copies them)
+    //! \returns the number of bytes accepted into the stream
+    size_t write(const std::string_view data);
+
+    //! Write a string of bytes into the stream, taking ownership of it
+    //! (avoids a copy in StorageMode::Chunks).
+    //! \returns the number of bytes accepted into the stream
+    size_t write(std::string &&data);
+
+    //! Write a refcounted Buffer into the stream (shares it in StorageMode::Chunks)
+    //! \returns the number of bytes accepted into the stream
+    size_t write(const Buffer &data);
+
+    //! \brief Copy `data` into the stream's free space, adding it to `checksum`, without writing it yet
+    //! \details In StorageMode::Chunks `data` is shared, not copied, and is only summed. The bytes
+    //! are written by commit(), and dropped by the next stage() or any other write.
+    //! \note `data` must fit in the remaining capacity
+    void stage(const Buffer &data, InternetChecksum &checksum);
+
+    //! Write the bytes staged last
+    void commit();
+
     //! \returns the number of additional bytes that the stream has space for
     size_t remaining_capacity() const;
 
@@ -51,6 +105,10 @@ class ByteStream {
     //! \returns a string
     std::string peek_output(const size_t len) const;
 
+    //! Peek at next "len" bytes of the stream without copying them
+    //! \returns views into the stream's storage, valid until the next write() or pop_output()
+    BufferViewList peek_views(const size_t len) const;
+
     //! Remove bytes from the buffer
     void pop_output(const size_t len);
 
@@ -58,6 +116,14 @@ class ByteStream {
     //! \returns a string
     std::string read(const size_t len);
 
+    //! Read (i.e., take and then pop) the next "len" bytes of the stream
+    //! \returns refcounted Buffers that stay valid after the bytes are popped
+    BufferList read_buffers(const size_t len);
+
+    //! Read the next "len" bytes of the stream, adding them to `checksum` as they are copied out
+    //! \returns refcounted Buffers that stay valid after the bytes are popped
+    BufferList read_buffers(const size_t len, InternetChecksum &checksum);
+
     //! \returns `true` if the stream input has ended
     bool input_ended() const;
 
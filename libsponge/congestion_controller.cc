@@ -0,0 +1,252 @@
+#include "congestion_controller.hh"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+//! \param[in] mss the maximum segment size, in bytes
+//! \details The initial window follows [RFC 6928](\ref rfc::rfc6928).
+CongestionController::CongestionController(const uint64_t mss)
+    : _mss(mss), _cwnd(min(10 * mss, max<uint64_t>(2 * mss, 14600))) {}
+
+//! \param[in] algorithm the algorithm to use
+//! \param[in] mss the maximum segment size, in bytes
+unique_ptr<CongestionController> CongestionController::create(const Algorithm algorithm, const uint64_t mss) {
+    switch (algorithm) {
+        case Algorithm::Reno:
+            return make_unique<RenoController>(mss, false);
+        case Algorithm::NewReno:
+            return make_unique<RenoController>(mss, true);
+        case Algorithm::Cubic:
+            return make_unique<CubicController>(mss);
+        case Algorithm::BBR:
+            return make_unique<BBRController>(mss);
+        default:
+            return nullptr;
+    }
+}
+
+//! \details Slow start grows the window by at most one MSS per ACK.
+void CongestionController::on_ack(const uint64_t acked, const uint64_t now) {
+    if (_cwnd < _ssthresh) {
+        _cwnd += min(acked, _mss);
+    } else {
+        congestion_avoidance(acked, now);
+    }
+}
+
+//! \details The window is inflated by the three segments that have left the network.
+void CongestionController::on_fast_retransmit(const uint64_t bytes_in_flight, const uint64_t now) {
+    _ssthresh = reduce(bytes_in_flight, now);
+    _cwnd = _ssthresh + 3 * _mss;
+}
+
+void CongestionController::on_recovery_dup_ack() { _cwnd += _mss; }
+
+//! \details Deflate the window by the amount acknowledged, then add back one MSS (RFC 6582).
+void CongestionController::on_partial_ack(const uint64_t acked) { _cwnd = (_cwnd > acked ? _cwnd - acked : 0) + _mss; }
+
+void CongestionController::on_recovery_end(const uint64_t bytes_in_flight) {
+    _cwnd = min(_ssthresh, max(bytes_in_flight, _mss) + _mss);
+}
+
+void CongestionController::on_timeout(const uint64_t bytes_in_flight, const uint64_t now) {
+    _ssthresh = reduce(bytes_in_flight, now);
+    _cwnd = _mss;
+}
+
+//! \details Appropriate byte counting ([RFC 3465](\ref rfc::rfc3465)): one MSS per window acknowledged.
+void RenoController::congestion_avoidance(const uint64_t acked, const uint64_t) {
+    _bytes_acked += acked;
+    if (_bytes_acked >= _cwnd) {
+        _bytes_acked -= _cwnd;
+        _cwnd += _mss;
+    }
+}
+
+uint64_t RenoController::reduce(const uint64_t bytes_in_flight, const uint64_t) {
+    _bytes_acked = 0;
+    return max(bytes_in_flight / 2, 2 * _mss);
+}
+
+//! \details The first ACK after a reduction starts a new epoch. The window then moves towards
+//! the larger of the cubic function and the Reno-friendly estimate, by at most half of itself
+//! per window acknowledged.
+void CubicController::congestion_avoidance(const uint64_t acked, const uint64_t now) {
+    const double cwnd = static_cast<double>(_cwnd) / _mss;
+
+    if (not _epoch_started) {
+        _epoch_started = true;
+        _epoch_start = now;
+        if (cwnd < _w_max) {
+            _k = cbrt((_w_max - cwnd) / C);
+        } else {
+            _k = 0;
+            _w_max = cwnd;
+        }
+        _w_est = cwnd;
+    }
+
+    const double t = static_cast<double>(now - _epoch_start) / 1000;
+    const double w_cubic = C * pow(t - _k, 3) + _w_max;
+    _w_est += 3 * (1 - BETA) / (1 + BETA) * (static_cast<double>(acked) / _mss) / cwnd;
+
+    const double target = min(max(w_cubic, _w_est), 1.5 * cwnd);
+    if (target > cwnd) {
+        _growth += (target - cwnd) / cwnd * static_cast<double>(acked);
+        const auto whole = static_cast<uint64_t>(_growth);
+        _cwnd += whole;
+        _growth -= static_cast<double>(whole);
+    }
+}
+
+//! \details With fast convergence: if the window had not regrown to its previous maximum,
+//! this flow is likely competing with new ones, so it releases bandwidth sooner. The new
+//! threshold is based on the bytes in flight, which after a timeout may exceed the window.
+uint64_t CubicController::reduce(const uint64_t bytes_in_flight, const uint64_t) {
+    const double cwnd = static_cast<double>(_cwnd) / _mss;
+    _w_max = cwnd < _w_max ? cwnd * (1 + BETA) / 2 : cwnd;
+    _epoch_started = false;
+    _growth = 0;
+    return max(static_cast<uint64_t>(llround(static_cast<double>(bytes_in_flight) * BETA)), 2 * _mss);
+}
+
+optional<uint64_t> BBRController::bdp() const {
+    if (_bw_samples.empty() or not _min_rtt.has_value()) {
+        return nullopt;
+    }
+    return static_cast<uint64_t>(bottleneck_bandwidth() * static_cast<double>(_min_rtt.value()));
+}
+
+//! \details Unpaced until the first bandwidth sample.
+optional<double> BBRController::pacing_rate() const {
+    if (_bw_samples.empty()) {
+        return nullopt;
+    }
+    return _pacing_gain * bottleneck_bandwidth();
+}
+
+void BBRController::on_rate_sample(const RateSample &sample, const uint64_t now) {
+    update_bandwidth(sample);
+    update_mode(sample, now);
+    update_min_rtt(sample, now);
+    update_window(sample);
+}
+
+void BBRController::enter_probe_bw(const uint64_t now) {
+    _mode = Mode::ProbeBW;
+    _cycle_index = 0;
+    _cycle_stamp = now;
+    _pacing_gain = PROBE_BW_GAINS[0];
+    _cwnd_gain = PROBE_BW_CWND_GAIN;
+}
+
+//! \details A round ends when a segment sent after the previous round ended is acknowledged.
+void BBRController::update_bandwidth(const RateSample &sample) {
+    const bool round_start = sample.prior_delivered >= _next_round_delivered;
+    if (round_start) {
+        _next_round_delivered = sample.total_delivered;
+        _round++;
+    }
+
+    // intervals shorter than a round trip are too short to measure the bottleneck
+    if (sample.delivered > 0 and sample.interval > 0 and sample.interval >= _min_rtt.value_or(0)) {
+        const double bw = static_cast<double>(sample.delivered) / static_cast<double>(sample.interval);
+        while (not _bw_samples.empty() and _bw_samples.back().second <= bw) {
+            _bw_samples.pop_back();
+        }
+        _bw_samples.emplace_back(_round, bw);
+    }
+    while (not _bw_samples.empty() and _bw_samples.front().first + BW_FILTER_ROUNDS <= _round) {
+        _bw_samples.pop_front();
+    }
+
+    if (round_start and not _filled_pipe and not _bw_samples.empty()) {
+        if (bottleneck_bandwidth() >= _full_bw * 1.25) {
+            _full_bw = bottleneck_bandwidth();
+            _full_bw_rounds = 0;
+        } else if (++_full_bw_rounds >= FULL_BW_ROUNDS) {
+            _filled_pipe = true;
+        }
+    }
+}
+
+void BBRController::update_mode(const RateSample &sample, const uint64_t now) {
+    if (_mode == Mode::Startup and _filled_pipe) {
+        _mode = Mode::Drain;
+        _pacing_gain = 1 / HIGH_GAIN;
+    }
+    if (_mode == Mode::Drain and sample.bytes_in_flight <= bdp().value_or(0)) {
+        enter_probe_bw(now);
+    }
+
+    // each phase lasts a round-trip time, but the draining phase ends once the queue is gone
+    if (_mode == Mode::ProbeBW and _min_rtt.has_value()) {
+        const bool elapsed = now - _cycle_stamp > _min_rtt.value();
+        const bool drained = _pacing_gain < 1 and sample.bytes_in_flight <= bdp().value_or(0);
+        if (elapsed or drained) {
+            _cycle_index = (_cycle_index + 1) % (sizeof(PROBE_BW_GAINS) / sizeof(PROBE_BW_GAINS[0]));
+            _cycle_stamp = now;
+            _pacing_gain = PROBE_BW_GAINS[_cycle_index];
+        }
+    }
+}
+
+void BBRController::update_min_rtt(const RateSample &sample, const uint64_t now) {
+    // a minimum can only expire once there is one: the first sample starts the clock, whenever it comes
+    const bool expired = _min_rtt.has_value() and now > _min_rtt_stamp + MIN_RTT_EXPIRY;
+    if (sample.rtt.has_value() and (not _min_rtt.has_value() or sample.rtt <= _min_rtt or expired)) {
+        _min_rtt = sample.rtt;
+        _min_rtt_stamp = now;
+    }
+
+    if (expired and _mode != Mode::ProbeRTT) {
+        _mode = Mode::ProbeRTT;
+        _pacing_gain = 1;
+        _cwnd_gain = 1;
+        _probe_rtt_done.reset();
+        _prior_cwnd = _cwnd;
+    }
+
+    if (_mode == Mode::ProbeRTT) {
+        if (not _probe_rtt_done.has_value()) {
+            if (sample.bytes_in_flight <= MIN_WINDOW_SEGMENTS * _mss) {
+                _probe_rtt_done = now + PROBE_RTT_DURATION;
+            }
+        } else if (now >= _probe_rtt_done.value()) {
+            _min_rtt_stamp = now;
+            _cwnd = max(_cwnd, _prior_cwnd);
+            if (_filled_pipe) {
+                enter_probe_bw(now);
+            } else {
+                _mode = Mode::Startup;
+                _pacing_gain = HIGH_GAIN;
+                _cwnd_gain = HIGH_GAIN;
+            }
+        }
+    }
+}
+
+//! \details The window grows by the bytes delivered until it reaches its target, so that it
+//! never jumps ahead of what the path has shown it can carry.
+void BBRController::update_window(const RateSample &sample) {
+    const uint64_t min_window = MIN_WINDOW_SEGMENTS * _mss;
+    if (_mode == Mode::ProbeRTT) {
+        _cwnd = min(_cwnd, min_window);
+        return;
+    }
+
+    const optional<uint64_t> bdp_bytes = bdp();
+    if (not bdp_bytes.has_value()) {
+        _cwnd += sample.delivered;
+        return;
+    }
+    const uint64_t target = max(static_cast<uint64_t>(_cwnd_gain * static_cast<double>(bdp_bytes.value())), min_window);
+    if (_filled_pipe) {
+        _cwnd = min(_cwnd + sample.delivered, target);
+    } else if (_cwnd < target) {
+        _cwnd += sample.delivered;
+    }
+    _cwnd = max(_cwnd, min_window);
+}
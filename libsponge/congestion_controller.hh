@@ -0,0 +1,227 @@
+#ifndef SPONGE_LIBSPONGE_CONGESTION_CONTROLLER_HH
+#define SPONGE_LIBSPONGE_CONGESTION_CONTROLLER_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <utility>
+
+//! \brief The congestion window of a TCPSender, and how it reacts to ACKs and losses.
+//!
+//! The TCPSender detects losses (three duplicate ACKs or a retransmission timeout) and runs
+//! fast retransmit and fast recovery ([RFC 5681](\ref rfc::rfc5681), [RFC 6582](\ref rfc::rfc6582));
+//! the controller only decides the window. This class implements slow start and the window
+//! changes during fast recovery; derived classes supply growth in congestion avoidance and the
+//! reduction after a loss. Model-based controllers instead derive the window, and a pacing rate,
+//! from the delivery rate samples the TCPSender takes on each ACK.
+class CongestionController {
+  public:
+    //! Available congestion control algorithms
+    enum class Algorithm {
+        None,     //!< No congestion window; send as much as the receiver's window allows
+        Reno,     //!< [RFC 5681](\ref rfc::rfc5681): any new ACK ends fast recovery
+        NewReno,  //!< [RFC 6582](\ref rfc::rfc6582): partial ACKs keep the sender in fast recovery
+        Cubic,    //!< [RFC 9438](\ref rfc::rfc9438), with NewReno's loss recovery
+        BBR       //!< Paces at the estimated bottleneck bandwidth; see BBRController
+    };
+
+    //! A delivery rate sample, taken when an ACK newly acknowledges or SACKs data
+    struct RateSample {
+        uint64_t delivered;           //!< Bytes delivered over the interval
+        uint64_t interval;            //!< Length of the interval, in ms
+        std::optional<uint64_t> rtt;  //!< Round-trip time of the segment, in ms, unless it was retransmitted
+        uint64_t prior_delivered;     //!< Bytes delivered when the segment was sent
+        uint64_t total_delivered;     //!< Bytes delivered so far
+        uint64_t bytes_in_flight;     //!< Bytes still in flight after the ACK
+    };
+
+  protected:
+    uint64_t _mss;                                             //!< Maximum segment size, in bytes
+    uint64_t _cwnd;                                            //!< Congestion window, in bytes
+    uint64_t _ssthresh{std::numeric_limits<uint64_t>::max()};  //!< Slow-start threshold, in bytes
+
+    //! Grow `_cwnd` in congestion avoidance, for `acked` newly acknowledged bytes at time `now`
+    virtual void congestion_avoidance(const uint64_t acked, const uint64_t now) = 0;
+
+    //! \returns the slow-start threshold after a loss, and records the loss
+    virtual uint64_t reduce(const uint64_t bytes_in_flight, const uint64_t now) = 0;
+
+  public:
+    //! \param[in] mss the maximum segment size, in bytes
+    explicit CongestionController(const uint64_t mss);
+
+    //! Create a controller for `algorithm`, or nothing for Algorithm::None
+    static std::unique_ptr<CongestionController> create(const Algorithm algorithm, const uint64_t mss);
+
+    //! The congestion window: the most bytes that may be in flight
+    uint64_t window() const { return _cwnd; }
+
+    //! The slow-start threshold
+    uint64_t slow_start_threshold() const { return _ssthresh; }
+
+    //! Does a partial ACK end fast recovery? (true for Reno, false for NewReno)
+    virtual bool partial_ack_ends_recovery() const { return false; }
+
+    //! The rate at which to release new segments, in bytes per ms, or nothing to send unpaced
+    virtual std::optional<double> pacing_rate() const { return std::nullopt; }
+
+    //! \name Events reported by the TCPSender; `now` is in milliseconds
+    //!@{
+
+    //! An ACK produced a delivery rate sample; reported before the other events for that ACK
+    virtual void on_rate_sample(const RateSample &, const uint64_t) {}
+
+    //! `acked` new bytes were acknowledged outside of fast recovery
+    virtual void on_ack(const uint64_t acked, const uint64_t now);
+
+    //! The third duplicate ACK arrived: fast retransmit and enter fast recovery
+    virtual void on_fast_retransmit(const uint64_t bytes_in_flight, const uint64_t now);
+
+    //! Another duplicate ACK arrived during fast recovery
+    virtual void on_recovery_dup_ack();
+
+    //! A partial ACK of `acked` bytes arrived during fast recovery
+    virtual void on_partial_ack(const uint64_t acked);
+
+    //! Fast recovery ended with `bytes_in_flight` bytes still outstanding
+    virtual void on_recovery_end(const uint64_t bytes_in_flight);
+
+    //! The retransmission timer expired
+    virtual void on_timeout(const uint64_t bytes_in_flight, const uint64_t now);
+    //!@}
+
+    virtual ~CongestionController() = default;
+};
+
+//! \brief Reno and NewReno: additive increase of one MSS per window, halving on loss
+class RenoController : public CongestionController {
+    bool _newreno;            //!< Stay in fast recovery until all data outstanding at the loss is acked
+    uint64_t _bytes_acked{};  //!< Bytes acknowledged in congestion avoidance since `_cwnd` last grew
+
+  protected:
+    void congestion_avoidance(const uint64_t acked, const uint64_t now) override;
+    uint64_t reduce(const uint64_t bytes_in_flight, const uint64_t now) override;
+
+  public:
+    RenoController(const uint64_t mss, const bool newreno) : CongestionController(mss), _newreno(newreno) {}
+
+    bool partial_ack_ends_recovery() const override { return not _newreno; }
+};
+
+//! \brief CUBIC: the window follows a cubic function of the time since the last loss
+//!
+//! The window is in MSS units when evaluating the cubic function. Growth never falls behind
+//! the window a Reno flow would have reached in the same time (the "TCP-friendly" region).
+class CubicController : public CongestionController {
+    static constexpr double C = 0.4;     //!< Scaling constant of the cubic function
+    static constexpr double BETA = 0.7;  //!< Multiplicative decrease factor
+
+    double _w_max{};             //!< Window (in MSS) just before the last reduction
+    double _k{};                 //!< Seconds for the cubic function to return to `_w_max`
+    double _w_est{};             //!< Window (in MSS) a Reno flow would have
+    bool _epoch_started{false};  //!< Has an ACK arrived since the last reduction?
+    uint64_t _epoch_start{};     //!< When the current congestion avoidance epoch began, in ms
+    double _growth{};            //!< Fraction of a byte of growth not yet added to `_cwnd`
+
+  protected:
+    void congestion_avoidance(const uint64_t acked, const uint64_t now) override;
+    uint64_t reduce(const uint64_t bytes_in_flight, const uint64_t now) override;
+
+  public:
+    explicit CubicController(const uint64_t mss) : CongestionController(mss) {}
+};
+
+//! \brief BBR: a model of the path's bottleneck bandwidth and round-trip propagation time
+//!
+//! The bandwidth estimate is the largest delivery rate seen in the last BW_FILTER_ROUNDS round
+//! trips; the round-trip estimate is the smallest RTT seen in the last MIN_RTT_EXPIRY ms. The
+//! sender is paced at a multiple of the bandwidth, and the window is a multiple of their
+//! product (the bandwidth-delay product, BDP). The multiples depend on the Mode:
+//!
+//! - Startup doubles the sending rate each round trip until the bandwidth stops growing by a
+//!   quarter for FULL_BW_ROUNDS rounds.
+//! - Drain then paces below the bandwidth until the queue built in Startup is gone.
+//! - ProbeBW cycles the pacing gain through PROBE_BW_GAINS, one phase per round-trip time.
+//! - ProbeRTT shrinks the window to MIN_WINDOW_SEGMENTS for PROBE_RTT_DURATION ms when the
+//!   round-trip estimate has expired, so that queues drain and a fresh minimum can be measured.
+//!
+//! Losses do not change the model; a retransmission timeout only restarts the window from one
+//! segment.
+class BBRController : public CongestionController {
+  public:
+    //! The phases of BBR's state machine
+    enum class Mode { Startup, Drain, ProbeBW, ProbeRTT };
+
+  private:
+    static constexpr double HIGH_GAIN = 2.885;                                   //!< 2/ln(2)
+    static constexpr double PROBE_BW_GAINS[] = {1.25, 0.75, 1, 1, 1, 1, 1, 1};  //!< Pacing gains in ProbeBW
+    static constexpr double PROBE_BW_CWND_GAIN = 2;                              //!< Window gain in ProbeBW
+    static constexpr uint64_t BW_FILTER_ROUNDS = 10;       //!< Rounds the bandwidth estimate lasts
+    static constexpr uint64_t MIN_RTT_EXPIRY = 10000;      //!< ms the round-trip estimate lasts
+    static constexpr uint64_t PROBE_RTT_DURATION = 200;    //!< ms spent with a small window in ProbeRTT
+    static constexpr unsigned int FULL_BW_ROUNDS = 3;      //!< Rounds without growth that end Startup
+    static constexpr uint64_t MIN_WINDOW_SEGMENTS = 4;     //!< Smallest window, in segments
+
+    Mode _mode{Mode::Startup};
+    double _pacing_gain{HIGH_GAIN};
+    double _cwnd_gain{HIGH_GAIN};
+
+    //! Delivery rates (bytes per ms) by round, decreasing, for a windowed maximum
+    std::deque<std::pair<uint64_t, double>> _bw_samples{};
+    uint64_t _round{0};                 //!< Round trips so far
+    uint64_t _next_round_delivered{0};  //!< Delivered bytes when the current round ends
+
+    std::optional<uint64_t> _min_rtt{};  //!< Round-trip propagation time estimate, in ms
+    uint64_t _min_rtt_stamp{0};          //!< When `_min_rtt` was measured
+
+    double _full_bw{0};                 //!< Bandwidth at the last growth in Startup
+    unsigned int _full_bw_rounds{0};    //!< Rounds since the last growth in Startup
+    bool _filled_pipe{false};           //!< Has Startup found the bandwidth?
+
+    size_t _cycle_index{0};                      //!< Current phase in PROBE_BW_GAINS
+    uint64_t _cycle_stamp{0};                    //!< When the current phase began
+    std::optional<uint64_t> _probe_rtt_done{};   //!< When ProbeRTT may end, once the window has drained
+    uint64_t _prior_cwnd{0};                     //!< The window on entering ProbeRTT, restored on leaving it
+
+    //! The bandwidth-delay product, in bytes, if both are known
+    std::optional<uint64_t> bdp() const;
+
+    void enter_probe_bw(const uint64_t now);
+    void update_bandwidth(const RateSample &sample);
+    void update_mode(const RateSample &sample, const uint64_t now);
+    void update_min_rtt(const RateSample &sample, const uint64_t now);
+    void update_window(const RateSample &sample);
+
+  protected:
+    void congestion_avoidance(const uint64_t, const uint64_t) override {}
+    uint64_t reduce(const uint64_t, const uint64_t) override { return _cwnd; }
+
+  public:
+    explicit BBRController(const uint64_t mss) : CongestionController(mss) {}
+
+    //! \name Model-based control replaces the loss-based events
+    //!@{
+    std::optional<double> pacing_rate() const override;
+    void on_rate_sample(const RateSample &sample, const uint64_t now) override;
+    void on_ack(const uint64_t, const uint64_t) override {}
+    void on_fast_retransmit(const uint64_t, const uint64_t) override {}
+    void on_recovery_dup_ack() override {}
+    void on_partial_ack(const uint64_t) override {}
+    void on_recovery_end(const uint64_t) override {}
+    void on_timeout(const uint64_t, const uint64_t) override { _cwnd = _mss; }
+    //!@}
+
+    //! The current phase
+    Mode mode() const { return _mode; }
+
+    //! The bottleneck bandwidth estimate, in bytes per ms (zero before any sample)
+    double bottleneck_bandwidth() const { return _bw_samples.empty() ? 0 : _bw_samples.front().second; }
+
+    //! The round-trip propagation time estimate, in ms
+    std::optional<uint64_t> min_rtt() const { return _min_rtt; }
+};
+
+#endif  // SPONGE_LIBSPONGE_CONGESTION_CONTROLLER_HH
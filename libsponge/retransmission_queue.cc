@@ -0,0 +1,46 @@
+#include "retransmission_queue.hh"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+//! \param[in] seqno the absolute sequence number of the segment
+//! \param[in] segment the segment, as it would be resent
+//! \param[in] transmission the sender's state as the segment was sent
+void RetransmissionQueue::push(const uint64_t seqno, TCPSegment segment, const Transmission &transmission) {
+    if (not _entries.empty() and _entries.back().end() != seqno) {
+        throw runtime_error("RetransmissionQueue::push: segment does not follow the last one");
+    }
+    _entries.push_back({seqno, move(segment), false, false, false, transmission});
+}
+
+//! \param[in] ackno the absolute ackno
+//! \details The SYN is acknowledged first, then the payload; a FIN is never acknowledged in
+//! part. The segment's wrapped seqno moves along with its absolute one.
+uint64_t RetransmissionQueue::trim(const uint64_t ackno) {
+    if (_entries.empty() or ackno <= _entries.front().seqno) {
+        return 0;
+    }
+    Entry &entry = _entries.front();
+    if (ackno >= entry.end()) {
+        throw out_of_range("RetransmissionQueue::trim: the whole segment was acknowledged");
+    }
+
+    TCPHeader &header = entry.segment.header();
+    uint64_t n = ackno - entry.seqno;
+    header.seqno = header.seqno + static_cast<uint32_t>(n);
+    entry.seqno = ackno;
+    if (header.syn) {
+        header.syn = false;
+        n--;
+    }
+    entry.segment.payload().remove_prefix(n);
+    return n;
+}
+
+//! \param[in] seqno an absolute sequence number
+RetransmissionQueue::iterator RetransmissionQueue::find(const uint64_t seqno) {
+    return partition_point(
+        _entries.begin(), _entries.end(), [seqno](const Entry &entry) { return entry.end() <= seqno; });
+}
@@ -0,0 +1,71 @@
+#ifndef SPONGE_LIBSPONGE_RETRANSMISSION_QUEUE_HH
+#define SPONGE_LIBSPONGE_RETRANSMISSION_QUEUE_HH
+
+#include "tcp_segment.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+//! \brief The segments a TCPSender has sent that have not yet been cumulatively acknowledged
+//!
+//! Segments are kept by absolute sequence number, in order and without gaps, so nothing needs
+//! to be unwrapped after they are sent. A cumulative ACK pops the segments it covers from the
+//! front and trims the one it covers only in part, so that a retransmission only resends what
+//! is still missing; the segment holding any sequence number is found by binary search. Each
+//! segment also carries its latest Transmission and the marks of the sender's SACK scoreboard.
+class RetransmissionQueue {
+  public:
+    //! The sender's state when a segment was last sent, for RTT and delivery rate samples
+    struct Transmission {
+        uint64_t sent_time;        //!< when the segment was sent
+        uint64_t first_sent_time;  //!< when the latest segment delivered before it was sent
+        uint64_t delivered;        //!< bytes delivered by then
+        uint64_t delivered_time;   //!< when those bytes had been delivered
+        unsigned int count;        //!< times the segment has been sent, for any reason
+    };
+
+    //! A segment that has been sent but not yet cumulatively acknowledged
+    struct Entry {
+        uint64_t seqno;             //!< absolute sequence number of the segment
+        TCPSegment segment;         //!< the segment as it is resent
+        bool sacked;                //!< the receiver reported holding the whole segment
+        bool delivered;             //!< counted as delivered, by a SACK or an ACK; a timeout does not undo it
+        bool retransmitted;         //!< resent since the last timeout, by fast retransmit or because of SACKs
+        Transmission transmission;  //!< the latest transmission of the segment
+
+        //! The absolute sequence number just past the segment
+        uint64_t end() const { return seqno + segment.length_in_sequence_space(); }
+    };
+
+    using iterator = std::deque<Entry>::iterator;
+
+  private:
+    std::deque<Entry> _entries{};
+
+  public:
+    //! \brief Add a segment that was just sent for the first time
+    //! \note `seqno` must be where the last segment in the queue ends
+    void push(const uint64_t seqno, TCPSegment segment, const Transmission &transmission);
+
+    //! \brief Remove the sequence numbers before `ackno` from the first segment, which must end after it
+    //! \returns the number of data bytes removed from its payload
+    uint64_t trim(const uint64_t ackno);
+
+    //! \brief The first segment that ends after `seqno` (the one holding it, if any), or end()
+    iterator find(const uint64_t seqno);
+
+    //! \name Access to the segments, in order
+    //!@{
+    Entry &front() { return _entries.front(); }
+    const Entry &front() const { return _entries.front(); }
+    Entry &back() { return _entries.back(); }
+    void pop_front() { _entries.pop_front(); }
+    iterator begin() { return _entries.begin(); }
+    iterator end() { return _entries.end(); }
+    bool empty() const { return _entries.empty(); }
+    size_t size() const { return _entries.size(); }
+    //!@}
+};
+
+#endif  // SPONGE_LIBSPONGE_RETRANSMISSION_QUEUE_HH
@@ -1,94 +1,499 @@
 #include "stream_reassembler.hh"
 
-// Dummy implementation of a stream reassembler.
+#include <algorithm>
+#include <cstring>
 
-// For Lab 1, please replace with a real implementation that passes the
-// automated checks run by `make check_lab1`.
-
-// You will need to add private members to the class declaration in `stream_reassembler.hh`
+// Stream reassembler backed by either an interval map or a slab with a bitmap of present bytes.
 
 using namespace std;
 
-StreamReassembler::StreamReassembler(const size_t capacity) : _output(capacity), _capacity(capacity){};
+//! \param[in] capacity the maximum number of bytes held, assembled or not
+//! \param[in] mode whether to keep out-of-order data as fragments or in a slab
+StreamReassembler::StreamReassembler(const size_t capacity, const StorageMode mode)
+    : _mode(mode)
+    , _slab(mode == StorageMode::Slab ? capacity : 0, 0)
+    , _present(mode == StorageMode::Slab ? (capacity + 63) / 64 : 0)
+    , _output(capacity)
+    , _capacity(capacity) {}
+
+//! \returns a word with bits [bit, bit + n) set (requires 0 < n and bit + n <= 64)
+static uint64_t bit_mask(const size_t bit, const size_t n) {
+    return (n == 64 ? ~uint64_t{0} : (uint64_t{1} << n) - 1) << bit;
+}
+
+//! Set bits [first, last) of `words`
+//! \returns the number of bits that were not already set
+static size_t set_bits(vector<uint64_t> &words, size_t first, const size_t last) {
+    size_t newly_set = 0;
+    while (first < last) {
+        const size_t bit = first % 64;
+        const size_t n = min(64 - bit, last - first);
+        const uint64_t mask = bit_mask(bit, n);
+        uint64_t &word = words[first / 64];
+        newly_set += __builtin_popcountll(mask & ~word);
+        word |= mask;
+        first += n;
+    }
+    return newly_set;
+}
+
+//! Clear bits [first, last) of `words`
+//! \returns the number of bits that were set
+static size_t clear_bits(vector<uint64_t> &words, size_t first, const size_t last) {
+    size_t cleared = 0;
+    while (first < last) {
+        const size_t bit = first % 64;
+        const size_t n = min(64 - bit, last - first);
+        const uint64_t mask = bit_mask(bit, n);
+        uint64_t &word = words[first / 64];
+        cleared += __builtin_popcountll(mask & word);
+        word &= ~mask;
+        first += n;
+    }
+    return cleared;
+}
+
+//! \returns the number of consecutive bits of `words` equal to `set`, starting at `first` (and before `last`)
+static size_t count_run(const vector<uint64_t> &words, size_t first, const size_t last, const bool set = true) {
+    size_t run = 0;
+    while (first < last) {
+        const size_t bit = first % 64;
+        const size_t n = min(64 - bit, last - first);
+        const uint64_t missing = (set ? ~words[first / 64] : words[first / 64]) & bit_mask(bit, n);
+        if (missing) {
+            return run + __builtin_ctzll(missing) - bit;
+        }
+        run += n;
+        first += n;
+    }
+    return run;
+}
+
+//! \returns the number of consecutive set bits of `words` ending at `last - 1` (and not before `first`)
+static size_t count_run_back(const vector<uint64_t> &words, const size_t first, size_t last) {
+    size_t run = 0;
+    while (first < last) {
+        const size_t bit = (last - 1) % 64;
+        const size_t n = min(bit + 1, last - first);
+        const uint64_t missing = ~words[(last - 1) / 64] & bit_mask(bit + 1 - n, n);
+        if (missing) {
+            return run + bit - (63 - __builtin_clzll(missing));
+        }
+        run += n;
+        last -= n;
+    }
+    return run;
+}
+
+//! \returns the number of set bits of `words` in [first, last) whose preceding bit is clear
+//! \param[in] prev_set whether the bit before `first` counts as set
+static size_t count_starts(const vector<uint64_t> &words, size_t first, const size_t last, bool prev_set) {
+    size_t starts = 0;
+    while (first < last) {
+        const size_t bit = first % 64;
+        const size_t n = min(64 - bit, last - first);
+        const uint64_t word = words[first / 64];
+        const uint64_t prev = ((word << 1) & ~(uint64_t{1} << bit)) | (uint64_t{prev_set} << bit);
+        starts += __builtin_popcountll(word & ~prev & bit_mask(bit, n));
+        prev_set = (word >> (bit + n - 1)) & 1;
+        first += n;
+    }
+    return starts;
+}
+
+size_t StreamReassembler::absent_run(const uint64_t first, const uint64_t last) const {
+    const size_t slot = first % _capacity;
+    const size_t head = min<size_t>(last - first, _capacity - slot);
+    const size_t run = count_run(_present, slot, slot + head, false);
+    return run < head ? run : head + count_run(_present, 0, last - first - head, false);
+}
+
+size_t StreamReassembler::present_run_back(const uint64_t first, const uint64_t last) const {
+    const size_t slot = first % _capacity;
+    const size_t head = min<size_t>(last - first, _capacity - slot);
+    const size_t tail = last - first - head;
+    const size_t run = count_run_back(_present, 0, tail);
+    return run < tail ? run : tail + count_run_back(_present, slot, slot + head);
+}
+
+//! \returns the number of runs of present bytes that overlap [first, last)
+size_t StreamReassembler::runs_within(const uint64_t first, const uint64_t last) const {
+    const size_t slot = first % _capacity;
+    const size_t head = min<size_t>(last - first, _capacity - slot);
+    const size_t starts = count_starts(_present, slot, slot + head, false);
+    if (head == last - first) {
+        return starts;
+    }
+    const bool wrapped_set = (_present[(_capacity - 1) / 64] >> ((_capacity - 1) % 64)) & 1;
+    return starts + count_starts(_present, 0, last - first - head, wrapped_set);
+}
+
+//! \details Only runs that overlap the marked range or touch its ends can merge, so the run
+//! count is corrected by recounting just that neighbourhood before and after.
+size_t StreamReassembler::mark_present(const uint64_t first, const uint64_t last) {
+    const uint64_t lo = first - 1;  // `first` is never the first unassembled byte
+    const uint64_t hi = min(last + 1, _output.bytes_read() + _capacity);
+    const size_t runs_before = runs_within(lo, hi);
+
+    const size_t slot = first % _capacity;
+    const size_t head = min<size_t>(last - first, _capacity - slot);
+    const size_t newly_set = set_bits(_present, slot, slot + head) + set_bits(_present, 0, last - first - head);
+
+    _runs = _runs + runs_within(lo, hi) - runs_before;
+    _slab_end = max(_slab_end, last);
+    return newly_set;
+}
+
+size_t StreamReassembler::mark_absent(const uint64_t first, const uint64_t last) {
+    const uint64_t hi = min(last + 1, _output.bytes_read() + _capacity);
+    const size_t runs_before = runs_within(first, hi);
+
+    const size_t slot = first % _capacity;
+    const size_t head = min<size_t>(last - first, _capacity - slot);
+    const size_t cleared = clear_bits(_present, slot, slot + head) + clear_bits(_present, 0, last - first - head);
+
+    _runs = _runs + runs_within(first, hi) - runs_before;
+    return cleared;
+}
+
+size_t StreamReassembler::present_run(const uint64_t first, const uint64_t last) const {
+    const size_t slot = first % _capacity;
+    const size_t head = min<size_t>(last - first, _capacity - slot);
+    const size_t run = count_run(_present, slot, slot + head);
+    return run < head ? run : head + count_run(_present, 0, last - first - head);
+}
+
+//! \param[in] data the bytes to store; must lie inside the acceptable window
+//! \param[in] index the stream index of the first byte of `data`
+//! \details Data that continues the stream is written to the ByteStream directly. Anything
+//! else is copied into its slots.
+void StreamReassembler::insert_slab(const string_view data, const uint64_t index) {
+    if (index == _output.bytes_written()) {
+        _output.write(data);
+        slab_written(index);
+        return;
+    }
+
+    const size_t slot = index % _capacity;
+    const size_t head = min(data.size(), _capacity - slot);
+    memcpy(_slab.data() + slot, data.data(), head);
+    memcpy(_slab.data(), data.data() + head, data.size() - head);
+    _unassembled_bytes += mark_present(index, index + data.size());
+}
+
+//! \param[in] index the stream index of the first byte written
+//! \details The slab's copies of the bytes just written are dropped. The run of present bytes
+//! that now continues the stream is then written from the slab (at most two spans) and its bits
+//! are cleared.
+void StreamReassembler::slab_written(const uint64_t index) {
+    if (_unassembled_bytes == 0) {
+        return;
+    }
+    _unassembled_bytes -= mark_absent(index, _output.bytes_written());
+
+    const uint64_t first = _output.bytes_written();
+    const size_t run = present_run(first, _output.bytes_read() + _capacity);
+    if (run > 0) {
+        const size_t slot = first % _capacity;
+        const size_t head = min(run, _capacity - slot);
+        _output.write(string_view(_slab).substr(slot, head));
+        _output.write(string_view(_slab).substr(0, run - head));
+        _unassembled_bytes -= mark_absent(first, first + run);
+    }
+}
+
+//! \returns whether fragment `b` begins exactly where fragment `a` (which precedes it) ends
+static bool touching(const pair<const uint64_t, Buffer> &a, const pair<const uint64_t, Buffer> &b) {
+    return a.first + a.second.size() == b.first;
+}
+
+//! \details A new fragment adds a run unless it touches a neighbour; touching both merges two runs.
+//! Fragments are never empty, so its neighbours cannot touch each other.
+void StreamReassembler::count_fragment(const FragmentMap::const_iterator it) {
+    _unassembled_bytes += it->second.size();
+    _runs++;
+    if (it != _fragments.begin() and touching(*std::prev(it), *it)) {
+        _runs--;
+    }
+    if (std::next(it) != _fragments.end() and touching(*it, *std::next(it))) {
+        _runs--;
+    }
+}
+
+void StreamReassembler::uncount_fragment(const FragmentMap::const_iterator it) {
+    _unassembled_bytes -= it->second.size();
+    _runs--;
+    if (it != _fragments.begin() and touching(*std::prev(it), *it)) {
+        _runs++;
+    }
+    if (std::next(it) != _fragments.end() and touching(*it, *std::next(it))) {
+        _runs++;
+    }
+}
+
+//! \param[in] index the stream index of the first byte of the new range; must not overlap the assembled stream
+//! \param[in] size the length of the new range
+//! \param[out] hint where a fragment for the returned range belongs in the map
+//! \details The neighbouring fragments are found with one map lookup. The new range is
+//! trimmed against the fragments that straddle its ends, and fragments lying entirely
+//! inside it are removed, so every stored byte is held exactly once.
+pair<uint64_t, uint64_t> StreamReassembler::make_room(const uint64_t index,
+                                                      const size_t size,
+                                                      FragmentMap::iterator &hint) {
+    uint64_t start = index;
+    uint64_t end = index + size;
+
+    auto it = _fragments.upper_bound(start);
+
+    // trim against the fragment starting at or before the new range
+    if (it != _fragments.begin()) {
+        const auto prev = std::prev(it);
+        start = max(start, prev->first + prev->second.size());
+    }
+
+    // remove fragments inside the range; trim against one that runs past its end
+    while (it != _fragments.end() and it->first < end) {
+        if (it->first + it->second.size() > end) {
+            end = it->first;
+            break;
+        }
+        uncount_fragment(it);
+        it = _fragments.erase(it);
+    }
 
-bool StreamReassembler::range_overlap(const std::pair<uint64_t, uint64_t> &r1,
-                                      const std::pair<uint64_t, uint64_t> &r2) {
-    return !(r1.second < r2.first || r1.first > r2.second);
+    hint = it;
+    return {start, end};
 }
-std::unique_ptr<StreamReassembler::datagram> StreamReassembler::merge_datagram(const datagram &d1, const datagram &d2) {
-    const datagram &lower = d1.range.first <= d2.range.first ? d1 : d2;
-    const datagram &larger = d1.range.second >= d2.range.second ? d1 : d2;
 
-    auto data = lower.data;
-    if (&lower != &larger)
-        data += larger.data.substr(lower.range.second - larger.range.first);
+//! \param[in] data the bytes to store, which are copied
+//! \param[in] index the stream index of the first byte of `data`
+void StreamReassembler::insert_fragment(const string_view data, const uint64_t index) {
+    FragmentMap::iterator hint;
+    const auto [start, end] = make_room(index, data.size(), hint);
+    if (start < end) {
+        count_fragment(_fragments.emplace_hint(hint, start, string(data.substr(start - index, end - start))));
+    }
+}
 
-    return make_unique<datagram>(data, std::pair<uint64_t, uint64_t>(lower.range.first, larger.range.second));
+//! \param[in] data the bytes to store, which are kept by reference
+//! \param[in] index the stream index of the first byte of `data`
+void StreamReassembler::insert_fragment(const Buffer &data, const uint64_t index) {
+    FragmentMap::iterator hint;
+    const auto [start, end] = make_room(index, data.size(), hint);
+    if (start < end) {
+        Buffer fragment = data;
+        fragment.remove_prefix(start - index);
+        fragment.remove_suffix(index + data.size() - end);
+        count_fragment(_fragments.emplace_hint(hint, start, move(fragment)));
+    }
+}
+
+//! \details Called after bytes were written straight to the stream: fragments they cover are
+//! dropped, and one that continues past them keeps only its remaining bytes.
+void StreamReassembler::discard_assembled() {
+    const uint64_t assembled = _output.bytes_written();
+    auto it = _fragments.begin();
+    while (it != _fragments.end() and it->first < assembled) {
+        uncount_fragment(it);
+        if (it->first + it->second.size() > assembled) {
+            Buffer rest = move(it->second);
+            rest.remove_prefix(assembled - it->first);
+            _fragments.erase(it);
+            count_fragment(_fragments.emplace_hint(_fragments.begin(), assembled, move(rest)));
+            return;
+        }
+        it = _fragments.erase(it);
+    }
+}
+
+//! \param[in] index the stream index of the first byte of the substring
+//! \param[in] size the length of the substring
+//! \param[in] eof whether the substring ends the stream
+pair<uint64_t, uint64_t> StreamReassembler::accept(const uint64_t index, const size_t size, const bool eof) {
+    // set eof position
+    if (eof) {
+        _eof = index + size;
+    }
+
+    // the acceptable window: from the first unassembled byte to the first byte beyond capacity
+    const uint64_t first_unassembled = _output.bytes_written();
+    const uint64_t first_unacceptable = _output.bytes_read() + _capacity;
+
+    return {max<uint64_t>(index, first_unassembled), min<uint64_t>(index + size, first_unacceptable)};
+}
+
+void StreamReassembler::assemble() {
+    for (auto front = _fragments.begin(); front != _fragments.end() and front->first == _output.bytes_written();
+         front = _fragments.erase(front)) {
+        uncount_fragment(front);
+        _output.write(front->second);
+    }
+
+    if (_eof == _output.bytes_written()) {
+        _output.end_input();
+    }
 }
 
 //! \details This function accepts a substring (aka a segment) of bytes,
 //! possibly out-of-order, from the logical stream, and assembles any newly
 //! contiguous substrings and writes them into the output stream in order.
 void StreamReassembler::push_substring(const string &data, const size_t index, const bool eof) {
-    // set eof position
-    if (eof) {
-        _eof = index + data.length();
+    push_substring(string_view(data), index, eof);
+}
+
+//! \details Bytes that continue the stream are written to it directly, without passing through
+//! a fragment.
+void StreamReassembler::push_substring(const string_view data, const uint64_t index, const bool eof) {
+    const auto [start, end] = accept(index, data.size(), eof);
+    if (start < end) {
+        const string_view accepted = data.substr(start - index, end - start);
+        if (_mode == StorageMode::Slab) {
+            insert_slab(accepted, start);
+        } else if (start == _output.bytes_written()) {
+            _output.write(accepted);
+            discard_assembled();
+        } else {
+            insert_fragment(accepted, start);
+        }
     }
+    assemble();
+}
 
-    // identify buffer start and end
-    auto buffer_start = _output.bytes_read();
-    auto buffer_end = buffer_start + _output.buffer_size();
+//! \details As for a std::string_view, but out-of-order bytes are kept as slices of `data`.
+void StreamReassembler::push_substring(const Buffer &data, const uint64_t index, const bool eof) {
+    if (_mode == StorageMode::Slab) {
+        push_substring(data.str(), index, eof);
+        return;
+    }
 
-    // range overflow, just ignore
-    if (index >= buffer_start + _capacity || index + data.length() <= buffer_end) {
-        if (_eof == buffer_start) {
-            _output.end_input();
+    const auto [start, end] = accept(index, data.size(), eof);
+    if (start < end) {
+        Buffer accepted = data;
+        accepted.remove_prefix(start - index);
+        accepted.remove_suffix(index + data.size() - end);
+        if (start == _output.bytes_written()) {
+            _output.write(accepted);
+            discard_assembled();
+        } else {
+            insert_fragment(accepted, start);
         }
-        return;
     }
+    assemble();
+}
 
-    // new datagram, throw overflowed
-    auto trancated_data = data.substr(0, buffer_start + _capacity - index);
-    auto new_datagram = std::make_unique<datagram>(
-        trancated_data, std::pair<uint64_t, uint64_t>{index, index + trancated_data.length()});
+//! \details The bytes that continue the stream are staged in it as they are summed (see
+//! ByteStream::stage()), so the common case of in-order data touches each byte once. Bytes that
+//! cannot be written yet are only summed, and stored as usual once the checksum is verified.
+//! \param[in] checksum the sum of everything the checksum covers but `data`
+bool StreamReassembler::push_substring(const Buffer &data,
+                                       const uint64_t index,
+                                       const bool eof,
+                                       InternetChecksum checksum) {
+    const uint64_t first_unassembled = _output.bytes_written();
+    const uint64_t last = min<uint64_t>(index + data.size(), _output.bytes_read() + _capacity);
 
-    auto overlapped_datagrams = std::vector<std::shared_ptr<datagram>>{};
+    size_t staged = 0;
+    if (index <= first_unassembled and first_unassembled < last) {
+        const size_t offset = first_unassembled - index;
+        staged = last - first_unassembled;
+        if (staged == data.size()) {
+            _output.stage(data, checksum);
+        } else {
+            Buffer next = data;
+            next.remove_prefix(offset);
+            next.remove_suffix(data.size() - offset - staged);
+            checksum.add(data.str().substr(0, offset));
+            _output.stage(next, checksum);
+            checksum.add(data.str().substr(offset + staged));
+        }
+    } else {
+        checksum.add(data);
+    }
+
+    if (checksum.value() != 0) {
+        return false;
+    }
 
-    for (const auto &datagram : _datagrams)
-        if (range_overlap(datagram->range, new_datagram->range)) {
-            overlapped_datagrams.emplace_back(datagram);
+    if (staged > 0) {
+        _output.commit();
+        if (_mode == StorageMode::Slab) {
+            slab_written(first_unassembled);
+        } else {
+            discard_assembled();
         }
+    }
+    // whatever was not staged is stored as usual, and the end of the stream recorded
+    push_substring(data, index, eof);
+    return true;
+}
+
+size_t StreamReassembler::unassembled_fragments() const {
+    return _mode == StorageMode::Slab ? _runs : _fragments.size();
+}
 
-    std::shared_ptr<datagram> merged_datagram = std::move(new_datagram);
-    for (const auto &datagram : overlapped_datagrams) {
-        merged_datagram = merge_datagram(*datagram, *merged_datagram);
-        // remove merged datagram
-        for (auto iter = _datagrams.begin(); iter != _datagrams.end(); ++iter)
-            if (*iter == datagram) {
-                _datagrams.erase(iter);
+optional<uint64_t> StreamReassembler::highest_buffered_index() const {
+    if (empty()) {
+        return nullopt;
+    }
+    if (_mode == StorageMode::Slab) {
+        return _slab_end - 1;
+    }
+    const auto &last = *_fragments.rbegin();
+    return last.first + last.second.size() - 1;
+}
+
+//! \param[in] limit the most ranges to return
+//! \details Adjacent fragments are reported as one range.
+vector<StreamReassembler::Range> StreamReassembler::buffered_ranges(const size_t limit) const {
+    vector<Range> ranges;
+    if (_mode == StorageMode::Slab) {
+        const uint64_t end = min(_slab_end, _output.bytes_read() + _capacity);
+        uint64_t index = _output.bytes_written();
+        while (ranges.size() < limit and index < end) {
+            index += absent_run(index, end);
+            if (index == end) {
                 break;
             }
+            const size_t run = present_run(index, end);
+            ranges.emplace_back(index, index + run);
+            index += run;
+        }
+        return ranges;
     }
 
-    if (index <= buffer_end) {
-        _output.write(merged_datagram->data.substr(max(buffer_end - index, 0ul)));
-
-        // buffer end updated
-        if (_eof == buffer_start + _output.buffer_size()) {
-            _output.end_input();
+    for (const auto &[index, data] : _fragments) {
+        if (not ranges.empty() and ranges.back().second == index) {
+            ranges.back().second += data.size();
+        } else if (ranges.size() < limit) {
+            ranges.emplace_back(index, index + data.size());
+        } else {
+            break;
         }
-        return;
     }
-
-    _datagrams.emplace_back(merged_datagram);
+    return ranges;
 }
 
-size_t StreamReassembler::unassembled_bytes() const {
-    size_t count = 0;
-    for (const auto &datagram : _datagrams) {
-        count += datagram->data.size();
+optional<StreamReassembler::Range> StreamReassembler::buffered_range_containing(const uint64_t index) const {
+    if (_mode == StorageMode::Slab) {
+        const uint64_t end = min(_slab_end, _output.bytes_read() + _capacity);
+        if (index < _output.bytes_written() or index >= end or present_run(index, index + 1) == 0) {
+            return nullopt;
+        }
+        return Range{index + 1 - present_run_back(_output.bytes_written(), index + 1),
+                     index + present_run(index, end)};
     }
-    return count;
-}
 
-bool StreamReassembler::empty() const { return unassembled_bytes() == 0; }
+    auto it = _fragments.upper_bound(index);
+    if (it == _fragments.begin() or std::prev(it)->first + std::prev(it)->second.size() <= index) {
+        return nullopt;
+    }
+    auto first = std::prev(it);
+    while (first != _fragments.begin() and touching(*std::prev(first), *first)) {
+        first--;
+    }
+    auto last = std::prev(it);
+    while (std::next(last) != _fragments.end() and touching(*last, *std::next(last))) {
+        last++;
+    }
+    return Range{first->first, last->first + last->second.size()};
+}
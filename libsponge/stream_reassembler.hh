@@ -1,41 +1,112 @@
 #ifndef SPONGE_LIBSPONGE_STREAM_REASSEMBLER_HH
 #define SPONGE_LIBSPONGE_STREAM_REASSEMBLER_HH
 
+#include "buffer.hh"
 #include "byte_stream.hh"
+#include "util.hh"
 
 #include <cstddef>
 #include <cstdint>
 #include <limits>
-#include <memory>
+#include <map>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
 //! \brief A class that assembles a series of excerpts from a byte stream (possibly out of order,
 //! possibly overlapping) into an in-order byte stream.
+//!
+//! By default, bytes that arrive ahead of the stream are kept in an ordered map from stream
+//! index to a fragment. Fragments never overlap: a new substring is trimmed against the
+//! fragments it overlaps, which are found in O(log n) from the map, and replaces those it covers.
+//! A substring pushed as a Buffer is kept by reference, without a copy; note that the fragment
+//! then keeps the Buffer's whole storage alive, not just the bytes it counts.
+//!
+//! Alternatively (StorageMode::Slab), the reassembler owns a single `capacity`-sized ring and a
+//! bitmap of which slots hold a byte. Out-of-order data is written in place, and a contiguous
+//! run is handed to the ByteStream straight from the ring, so there are no per-fragment
+//! allocations and memory is fixed at `capacity`.
+//!
+//! In both modes the number of unassembled bytes and the number of holes are kept up to date
+//! as data is stored and assembled, so querying them never walks the stored data.
 class StreamReassembler {
+  public:
+    //! How the reassembler stores bytes that cannot be assembled yet
+    enum class StorageMode {
+        Fragments,  //!< One string per fragment in an ordered map
+        Slab        //!< A preallocated ring plus a bitmap of present bytes
+    };
+
   private:
-    struct datagram {
-        std::string data;
-        std::pair<uint64_t, uint64_t> range;
+    StorageMode _mode;
 
-        datagram(std::string data, std::pair<uint64_t, uint64_t> range) : data(std::move(data)), range(range) {}
-        datagram(const datagram &datagram) : data(datagram.data), range(datagram.range) {}
-    };
+    using FragmentMap = std::map<uint64_t, Buffer>;
+
+    FragmentMap _fragments{};  //!< Unassembled bytes, keyed by index of their first byte
+
+    std::string _slab;               //!< Ring of `capacity` slots; stream index `i` lives in slot `i % capacity`
+    std::vector<uint64_t> _present;  //!< One bit per slot of `_slab`, set if the slot holds an unassembled byte
+    uint64_t _slab_end{};            //!< Largest index one past a byte ever written into the slab
+
+    size_t _unassembled_bytes{};  //!< Number of bytes stored but not yet assembled
+    size_t _runs{};               //!< Number of maximal runs of contiguous unassembled bytes
 
-    std::vector<std::shared_ptr<datagram>> _datagrams{};
     ByteStream _output;  //!< The reassembled in-order byte stream
     size_t _capacity;    //!< The maximum number of bytes
-    size_t _eof{std::numeric_limits<size_t>::max()};
 
-    bool range_overlap(const std::pair<uint64_t, uint64_t> &r1, const std::pair<uint64_t, uint64_t> &r2);
-    std::unique_ptr<datagram> merge_datagram(const datagram &d1, const datagram &d2);
+    //! Index one past the last byte of the stream, once known
+    uint64_t _eof{std::numeric_limits<uint64_t>::max()};
+
+    //! \brief Drop the fragments inside [index, index + size) and trim the range against those straddling its ends
+    //! \returns the part of the range not already held, and where to insert it into the map
+    std::pair<uint64_t, uint64_t> make_room(const uint64_t index, const size_t size, FragmentMap::iterator &hint);
+
+    //! \name Store the bytes of `data` (starting at `index`) that are not already held
+    //!@{
+    void insert_fragment(const std::string_view data, const uint64_t index);
+    void insert_fragment(const Buffer &data, const uint64_t index);
+    //!@}
+
+    //! Drop or trim the fragments that start before the end of the assembled stream
+    void discard_assembled();
+
+    //! \brief Record the end of the stream if `eof`, and find the acceptable part of a substring
+    //! \returns the stream indices `[first, last)` of the bytes of `[index, index + size)` to store,
+    //! which are none if `first >= last`
+    std::pair<uint64_t, uint64_t> accept(const uint64_t index, const size_t size, const bool eof);
+
+    //! Hand over the fragments that now continue the stream, and end it once it is complete
+    void assemble();
+
+    //! \name Update the byte and run counts when the fragment at `it` enters or leaves the map
+    //!@{
+    void count_fragment(const FragmentMap::const_iterator it);
+    void uncount_fragment(const FragmentMap::const_iterator it);
+    //!@}
+
+    //! Write `data` (starting at `index`) into the slab, or straight into the stream if it is next
+    void insert_slab(const std::string_view data, const uint64_t index);
+
+    //! Update the slab after the bytes from `index` up were written straight to the stream
+    void slab_written(const uint64_t index);
+
+    //! \name Bitmap helpers for the slab; each range is in stream indices and at most `capacity` long
+    //!@{
+    size_t mark_present(const uint64_t first, const uint64_t last);
+    size_t mark_absent(const uint64_t first, const uint64_t last);
+    size_t present_run(const uint64_t first, const uint64_t last) const;
+    size_t absent_run(const uint64_t first, const uint64_t last) const;
+    size_t present_run_back(const uint64_t first, const uint64_t last) const;
+    size_t runs_within(const uint64_t first, const uint64_t last) const;
+    //!@}
 
   public:
     //! \brief Construct a `StreamReassembler` that will store up to `capacity` bytes.
     //! \note This capacity limits both the bytes that have been reassembled,
     //! and those that have not yet been reassembled.
-    StreamReassembler(const size_t capacity);
+    StreamReassembler(const size_t capacity, const StorageMode mode = StorageMode::Fragments);
 
     //! \brief Receive a substring and write any newly contiguous bytes into the stream.
     //!
@@ -47,6 +118,20 @@ class StreamReassembler {
     //! \param eof the last byte of `data` will be the last byte in the entire stream
     void push_substring(const std::string &data, const uint64_t index, const bool eof);
 
+    //! \brief Receive a substring without copying it first
+    //! \note Bytes written to the stream are copied straight from `data`; out-of-order bytes are
+    //! copied into fragments (or the slab)
+    void push_substring(const std::string_view data, const uint64_t index, const bool eof);
+
+    //! \brief Receive a substring held in a refcounted Buffer (e.g. a TCPSegment's payload)
+    //! \note Out-of-order bytes are kept as slices of `data` rather than copied, except in StorageMode::Slab
+    void push_substring(const Buffer &data, const uint64_t index, const bool eof);
+
+    //! \brief Receive a substring whose checksum has yet to be verified (see TCPSegment::deferred_checksum())
+    //! \note All of `data` is added to `checksum`, and nothing is stored unless the result is correct
+    //! \returns `true` if the checksum was correct
+    bool push_substring(const Buffer &data, const uint64_t index, const bool eof, InternetChecksum checksum);
+
     //! \name Access the reassembled byte stream
     //!@{
     const ByteStream &stream_out() const { return _output; }
@@ -57,11 +142,32 @@ class StreamReassembler {
     //!
     //! \note If the byte at a particular index has been pushed more than once, it
     //! should only be counted once for the purpose of this function.
-    size_t unassembled_bytes() const;
+    size_t unassembled_bytes() const { return _unassembled_bytes; }
+
+    //! The number of pieces the unassembled bytes are stored in
+    //!
+    //! \note Adjacent fragments are not merged, so with StorageMode::Fragments this can exceed
+    //! holes(). With StorageMode::Slab each run of contiguous bytes counts as one.
+    size_t unassembled_fragments() const;
+
+    //! The number of gaps in the stream between the assembled bytes and the last unassembled byte
+    size_t holes() const { return _runs; }
+
+    //! The index of the last unassembled byte, or nothing if no bytes are waiting
+    std::optional<uint64_t> highest_buffered_index() const;
+
+    //! A range of stream indices `[first, last)`
+    using Range = std::pair<uint64_t, uint64_t>;
+
+    //! The lowest `limit` runs of contiguous unassembled bytes, in increasing order
+    std::vector<Range> buffered_ranges(const size_t limit) const;
+
+    //! The run of contiguous unassembled bytes that holds `index`, if that byte is held
+    std::optional<Range> buffered_range_containing(const uint64_t index) const;
 
     //! \brief Is the internal state empty (other than the output stream)?
     //! \returns `true` if no substrings are waiting to be assembled
-    bool empty() const;
+    bool empty() const { return _unassembled_bytes == 0; }
 };
 
 #endif  // SPONGE_LIBSPONGE_STREAM_REASSEMBLER_HH
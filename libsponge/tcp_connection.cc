@@ -1,6 +1,8 @@
 #include "tcp_connection.hh"
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
 
 using namespace std;
 
@@ -12,6 +14,14 @@ size_t TCPConnection::unassembled_bytes() const { return _receiver.unassembled_b
 
 size_t TCPConnection::time_since_last_segment_received() const { return _time - _last_segment_received; }
 
+optional<uint64_t> TCPConnection::latest_rtt() const { return _sender.latest_rtt(); }
+
+optional<double> TCPConnection::smoothed_rtt() const { return _sender.smoothed_rtt(); }
+
+optional<double> TCPConnection::rtt_variation() const { return _sender.rtt_variation(); }
+
+unsigned int TCPConnection::retransmission_timeout() const { return _sender.retransmission_timeout(); }
+
 void TCPConnection::segment_received(const TCPSegment &seg) {
     // reset received, end connection
     if (seg.header().rst) {
@@ -24,29 +34,79 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
     if (!seg.header().syn && !_receiver.ackno().has_value())
         return;
 
+    // PAWS: drop a segment with an old timestamp, but acknowledge it (RFC 7323)
+    if (_timestamps_enabled && _receiver.outdated(seg)) {
+        if (!seg.verify_deferred_checksum())
+            return;
+        _sender.send_empty_segment();
+        push_segments_out();
+        return;
+    }
+
     // peer get eof first, no need to wait after stream finish
     if (seg.header().fin && !_sender.stream_in().eof())
         _linger_after_streams_finish = false;
 
+    // SACK, window scaling and timestamps are used only if both SYNs offered them
+    if (seg.header().syn) {
+        _sack_enabled = _cfg.sack && seg.header().sack_permitted;
+        _timestamps_enabled = _cfg.timestamps && seg.header().timestamps.has_value();
+        _window_scaling_enabled = _cfg.window_scaling && seg.header().wscale.has_value();
+        _send_window_shift =
+            _window_scaling_enabled ? min(seg.header().wscale.value(), TCPHeader::MAX_WINDOW_SHIFT) : 0;
+        _recv_window_shift = _window_scaling_enabled ? _cfg.window_shift() : 0;
+    }
+
     // give it to receiver
-    _receiver.segment_received(seg);
+    const bool had_unassembled_bytes = _receiver.unassembled_bytes() > 0;
+    if (!_receiver.segment_received(seg))
+        return;
     // record time
     _last_segment_received = _time;
 
     // give it to sender if ack set
-    if (seg.header().ack)
-        _sender.ack_received(seg.header().ackno, seg.header().win);
+    if (seg.header().ack) {
+        static const vector<TCPHeader::SACKBlock> no_sack{};
+        // the window in a SYN is never scaled
+        const uint64_t window = uint64_t{seg.header().win} << (seg.header().syn ? 0 : _send_window_shift);
+        optional<uint32_t> echoed_timestamp{};
+        if (_timestamps_enabled && seg.header().timestamps.has_value())
+            echoed_timestamp = seg.header().timestamps->tsecr;
+        _sender.ack_received(seg.header().ackno,
+                             window,
+                             _sack_enabled ? seg.header().sack : no_sack,
+                             seg.length_in_sequence_space() == 0,
+                             echoed_timestamp);
+    }
 
     // just try to send some segments
     _sender.fill_window();
 
     // send empty segment if coming segment occupy at least one seqno
-    if (seg.length_in_sequence_space() > 0 && _sender.segments_out().empty()) {
+    if (seg.length_in_sequence_space() > 0 && _sender.segments_out().empty() &&
+        !ack_can_wait(seg, had_unassembled_bytes)) {
         _sender.send_empty_segment();
     }
     push_segments_out();
 }
 
+//! \details Only in-order data with nothing out of order behind it may wait, and only until
+//! two full-sized segments' worth is unacknowledged (RFC 1122, [RFC 5681](\ref rfc::rfc5681)).
+//! SYNs, FINs, out-of-order segments and segments that fill a hole are acknowledged at once.
+bool TCPConnection::ack_can_wait(const TCPSegment &seg, const bool had_unassembled_bytes) {
+    if (!_cfg.delayed_ack || seg.header().syn || seg.header().fin || had_unassembled_bytes ||
+        _receiver.unassembled_bytes() > 0 || _receiver.ackno() != seg.header().seqno + seg.length_in_sequence_space())
+        return false;
+
+    _unacknowledged_bytes += seg.payload().size();
+    if (_unacknowledged_bytes >= 2 * TCPConfig::MAX_PAYLOAD_SIZE)
+        return false;
+
+    if (!_ack_deadline.has_value())
+        _ack_deadline = _time + _cfg.ack_delay;
+    return true;
+}
+
 bool TCPConnection::active() const {
     if (_sender.stream_in().error() || _receiver.stream_out().error())
         return false;
@@ -67,6 +127,13 @@ size_t TCPConnection::write(const string &data) {
     return bytes_written;
 }
 
+size_t TCPConnection::write(string &&data) {
+    const size_t bytes_written = _sender.stream_in().write(move(data));
+    _sender.fill_window();
+    push_segments_out();
+    return bytes_written;
+}
+
 //! \param[in] ms_since_last_tick number of milliseconds since the last call to this method
 void TCPConnection::tick(const size_t ms_since_last_tick) {
     _time += ms_since_last_tick;
@@ -79,6 +146,10 @@ void TCPConnection::tick(const size_t ms_since_last_tick) {
         return;
     }
 
+    // a delayed ACK that no data has carried yet
+    if (_ack_deadline.has_value() && _time >= _ack_deadline.value() && _sender.segments_out().empty())
+        _sender.send_empty_segment();
+
     push_segments_out();
 }
 
@@ -95,28 +166,50 @@ void TCPConnection::connect() {
 
 void TCPConnection::push_segments_out() {
     while (!_sender.segments_out().empty()) {
-        TCPSegment new_seg = _sender.segments_out().front();
+        TCPSegment new_seg = move(_sender.segments_out().front());
         _sender.segments_out().pop();
 
+        if (new_seg.header().syn) {
+            new_seg.header().sack_permitted = _cfg.sack;
+            // a SYN/ACK may only offer scaling to a peer whose SYN offered it ([RFC 7323](\ref rfc::rfc7323))
+            if (_receiver.ackno().has_value() ? _window_scaling_enabled : _cfg.window_scaling)
+                new_seg.header().wscale = _cfg.window_shift();
+        }
+
+        // until the peer's SYN arrives, only our SYN can offer timestamps
+        if (_receiver.ackno().has_value() ? _timestamps_enabled : (_cfg.timestamps && new_seg.header().syn))
+            new_seg.header().timestamps = TCPHeader::Timestamps{_sender.timestamp(), _receiver.ts_recent().value_or(0)};
+
         // fill in the ack if possible
         if (_receiver.ackno().has_value()) {
             new_seg.header().ack = true;
             new_seg.header().ackno = _receiver.ackno().value();
-            new_seg.header().win = _receiver.window_size() > std::numeric_limits<uint16_t>::max()
-                                       ? std::numeric_limits<uint16_t>::max()
-                                       : _receiver.window_size();
+            // the window in a SYN is never scaled
+            const size_t window = _receiver.window_size() >> (new_seg.header().syn ? 0 : _recv_window_shift);
+            new_seg.header().win = min<size_t>(window, numeric_limits<uint16_t>::max());
+            if (_sack_enabled) {
+                const size_t max_blocks =
+                    _timestamps_enabled ? TCPHeader::MAX_SACK_BLOCKS_WITH_TIMESTAMPS : TCPHeader::MAX_SACK_BLOCKS;
+                new_seg.header().sack = _receiver.sack_blocks(max_blocks);
+            }
+        }
+
+        // any segment with an ACK is as good as a delayed one
+        if (new_seg.header().ack) {
+            _unacknowledged_bytes = 0;
+            _ack_deadline.reset();
         }
 
-        _segments_out.push(new_seg);
+        _segments_out.push(move(new_seg));
     }
 }
 
 void TCPConnection::send_reset() {
     _sender.send_empty_segment();
-    TCPSegment new_seg = _sender.segments_out().front();
+    TCPSegment new_seg = move(_sender.segments_out().front());
     _sender.segments_out().pop();
     new_seg.header().rst = true;
-    _segments_out.push(new_seg);
+    _segments_out.push(move(new_seg));
 }
 
 TCPConnection::~TCPConnection() {
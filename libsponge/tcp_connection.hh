@@ -7,13 +7,15 @@
 #include "tcp_state.hh"
 
 #include <cstddef>
+#include <cstdint>
+#include <optional>
 
 //! \brief A complete endpoint of a TCP connection
 class TCPConnection {
   private:
     TCPConfig _cfg;
-    TCPReceiver _receiver{_cfg.recv_capacity};
-    TCPSender _sender{_cfg.send_capacity, _cfg.rt_timeout, _cfg.fixed_isn};
+    TCPReceiver _receiver{_cfg.recv_capacity, _cfg.recv_storage, _cfg.timestamps};
+    TCPSender _sender{_cfg};
 
     //! outbound queue of segments that the TCPConnection wants sent
     std::queue<TCPSegment> _segments_out{};
@@ -23,6 +25,30 @@ class TCPConnection {
     //! in case the remote TCPConnection doesn't know we've received its whole stream?
     bool _linger_after_streams_finish{true};
 
+    //! Did both sides offer SACK in their SYNs?
+    bool _sack_enabled{false};
+
+    //! Did both sides offer window scaling in their SYNs?
+    bool _window_scaling_enabled{false};
+
+    //! Did both sides offer timestamps in their SYNs?
+    bool _timestamps_enabled{false};
+
+    //! \name Window scale shifts (RFC 7323), both zero unless both SYNs offered scaling
+    //!@{
+    uint8_t _send_window_shift{0};  //!< applied to windows the peer advertises
+    uint8_t _recv_window_shift{0};  //!< applied to windows we advertise
+    //!@}
+
+    //! \name Delayed ACK (TCPConfig::delayed_ack)
+    //!@{
+    size_t _unacknowledged_bytes{0};        //!< payload received since an ACK was last sent
+    std::optional<size_t> _ack_deadline{};  //!< when the delayed ACK must be sent, if one is pending
+    //!@}
+
+    //! may the ACK for `seg` wait? `had_unassembled_bytes` says if out-of-order data was held before it
+    bool ack_can_wait(const TCPSegment &seg, const bool had_unassembled_bytes);
+
     //! send empty segment with reset flag, then close connection
     void send_reset();
 
@@ -46,6 +72,10 @@ class TCPConnection {
     //! \returns the number of bytes from `data` that were actually written.
     size_t write(const std::string &data);
 
+    //! \brief Write data to the outbound byte stream, taking ownership of the string
+    //! \returns the number of bytes from `data` that were actually written.
+    size_t write(std::string &&data);
+
     //! \returns the number of `bytes` that can be written right now.
     size_t remaining_outbound_capacity() const;
 
@@ -69,6 +99,14 @@ class TCPConnection {
     size_t unassembled_bytes() const;
     //! \brief Number of milliseconds since the last segment was received
     size_t time_since_last_segment_received() const;
+    //! \brief the most recent round-trip time measured by the sender, in ms
+    std::optional<uint64_t> latest_rtt() const;
+    //! \brief the sender's smoothed round-trip time (SRTT), in ms
+    std::optional<double> smoothed_rtt() const;
+    //! \brief the sender's round-trip time variation (RTTVAR), in ms
+    std::optional<double> rtt_variation() const;
+    //! \brief the sender's current retransmission timeout, in ms
+    unsigned int retransmission_timeout() const;
     //!< \brief summarize the state of the sender, receiver, and the connection
     TCPState state() const { return {_sender, _receiver, active(), _linger_after_streams_finish}; };
     //!@}
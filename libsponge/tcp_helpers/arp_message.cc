@@ -1,41 +1,40 @@
 #include "arp_message.hh"
 
+#include <algorithm>
 #include <arpa/inet.h>
 #include <iomanip>
 #include <sstream>
+#include <string_view>
 
 using namespace std;
 
 ParseResult ARPMessage::parse(const Buffer buffer) {
     NetParser p{buffer};
-
-    if (p.buffer().size() < ARPMessage::LENGTH) {
-        return ParseResult::PacketTooShort;
+    const string_view message = p.take(ARPMessage::LENGTH);
+    if (p.error()) {
+        return p.get_error();
     }
+    const char *m = message.data();
 
-    hardware_type = p.u16();
-    protocol_type = p.u16();
-    hardware_address_size = p.u8();
-    protocol_address_size = p.u8();
-    opcode = p.u16();
+    hardware_type = NetParser::load_u16(m);
+    protocol_type = NetParser::load_u16(m + 2);
+    hardware_address_size = NetParser::load_u8(m + 4);
+    protocol_address_size = NetParser::load_u8(m + 5);
+    opcode = NetParser::load_u16(m + 6);
 
     if (not supported()) {
         return ParseResult::Unsupported;
     }
 
     // read sender addresses (Ethernet and IP)
-    for (auto &byte : sender_ethernet_address) {
-        byte = p.u8();
-    }
-    sender_ip_address = p.u32();
+    copy(m + 8, m + 14, sender_ethernet_address.begin());
+    sender_ip_address = NetParser::load_u32(m + 14);
 
     // read target addresses (Ethernet and IP)
-    for (auto &byte : target_ethernet_address) {
-        byte = p.u8();
-    }
-    target_ip_address = p.u32();
+    copy(m + 18, m + 24, target_ethernet_address.begin());
+    target_ip_address = NetParser::load_u32(m + 24);
 
-    return p.get_error();
+    return ParseResult::NoError;
 }
 
 bool ARPMessage::supported() const {
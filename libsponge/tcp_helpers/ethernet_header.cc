@@ -2,50 +2,46 @@
 
 #include "util.hh"
 
+#include <algorithm>
 #include <iomanip>
 #include <sstream>
+#include <string_view>
 
 using namespace std;
 
 ParseResult EthernetHeader::parse(NetParser &p) {
-    if (p.buffer().size() < EthernetHeader::LENGTH) {
-        return ParseResult::PacketTooShort;
+    const string_view header = p.take(EthernetHeader::LENGTH);
+    if (p.error()) {
+        return p.get_error();
     }
 
     /* read destination address */
-    for (auto &byte : dst) {
-        byte = p.u8();
-    }
+    copy(header.begin(), header.begin() + dst.size(), dst.begin());
 
     /* read source address */
-    for (auto &byte : src) {
-        byte = p.u8();
-    }
+    copy(header.begin() + dst.size(), header.begin() + dst.size() + src.size(), src.begin());
 
     /* read the frame's type (e.g. IPv4, ARP, or something else) */
-    type = p.u16();
+    type = NetParser::load_u16(header.data() + dst.size() + src.size());
 
-    return p.get_error();
+    return ParseResult::NoError;
 }
 
 string EthernetHeader::serialize() const {
-    string ret;
-    ret.reserve(LENGTH);
+    string ret(LENGTH, 0);
+    serialize_into(ret.data());
+    return ret;
+}
 
+void EthernetHeader::serialize_into(char *out) const {
     /* write destination address */
-    for (auto &byte : dst) {
-        NetUnparser::u8(ret, byte);
-    }
+    copy(dst.begin(), dst.end(), out);
 
     /* write source address */
-    for (auto &byte : src) {
-        NetUnparser::u8(ret, byte);
-    }
+    copy(src.begin(), src.end(), out + dst.size());
 
     /* write the frame's type (e.g. IPv4, ARP or something else) */
-    NetUnparser::u16(ret, type);
-
-    return ret;
+    NetUnparser::u16(out + dst.size() + src.size(), type);
 }
 
 //! \returns A string with a textual representation of an Ethernet address
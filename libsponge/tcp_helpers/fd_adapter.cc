@@ -28,7 +28,7 @@ optional<TCPSegment> TCPOverUDPSocketAdapter::read() {
 
     // is the payload a valid TCP segment?
     TCPSegment seg;
-    if (ParseResult::NoError != seg.parse(move(datagram.payload), 0)) {
+    if (ParseResult::NoError != seg.parse(move(datagram.payload), 0, config().defer_payload_checksum)) {
         return {};
     }
 
@@ -46,11 +46,19 @@ optional<TCPSegment> TCPOverUDPSocketAdapter::read() {
 }
 
 //! Serialize a TCP segment and send it as the payload of a UDP datagram.
+//! A segment with more than TCPConfig::MAX_PAYLOAD_SIZE bytes of payload (see
+//! TCPConfig::segmentation_offload) is split, and each piece is sent in its own datagram.
 //! \param[in] seg is the TCP segment to write
 void TCPOverUDPSocketAdapter::write(TCPSegment &seg) {
     seg.header().sport = config().source.port();
     seg.header().dport = config().destination.port();
-    _sock.sendto(config().destination, seg.serialize(0));
+    if (seg.payload().size() <= TCPConfig::MAX_PAYLOAD_SIZE) {
+        _sock.sendto(config().destination, seg.serialize(0));
+        return;
+    }
+    for (const TCPSegment &piece : seg.split(TCPConfig::MAX_PAYLOAD_SIZE)) {
+        _sock.sendto(config().destination, piece.serialize(0));
+    }
 }
 
 //! Specialize LossyFdAdapter to TCPOverUDPSocketAdapter
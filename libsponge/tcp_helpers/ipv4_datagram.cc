@@ -25,17 +25,11 @@ BufferList IPv4Datagram::serialize() const {
         throw runtime_error("IPv4Datagram::serialize: payload is wrong size");
     }
 
-    IPv4Header header_out = _header;
-    header_out.cksum = 0;
-    const string header_zero_checksum = header_out.serialize();
-
-    // calculate checksum -- taken over header only
-    InternetChecksum check;
-    check.add(header_zero_checksum);
-    header_out.cksum = check.value();
+    string header(4 * _header.hlen, 0);
+    _header.serialize_into(header.data(), true);
 
     BufferList ret;
-    ret.append(header_out.serialize());
+    ret.append(move(header));
     ret.append(_payload);
     return ret;
 }
@@ -7,6 +7,8 @@
 //! \note IP options are not supported
 struct IPv4Header {
     static constexpr size_t LENGTH = 20;         //!< [IPv4](\ref rfc::rfc791) header length, not including options
+    static constexpr size_t MAX_LENGTH = 60;     //!< Longest header that `hlen` can describe
+    static constexpr size_t CKSUM_OFFSET = 10;   //!< Offset of the checksum, to fill it in place
     static constexpr uint8_t DEFAULT_TTL = 128;  //!< A reasonable default TTL value
     static constexpr uint8_t PROTO_TCP = 6;      //!< Protocol number for [tcp](\ref rfc::rfc793)
 
@@ -52,6 +54,10 @@ struct IPv4Header {
     //! Serialize the IP fields
     std::string serialize() const;
 
+    //! \brief Serialize the IP fields into `out`, which must have room for `4 * hlen` bytes
+    //! \details With `fill_checksum`, the checksum is computed over the serialized header in place of `cksum`
+    void serialize_into(char *out, const bool fill_checksum = false) const;
+
     //! Length of the payload
     uint16_t payload_length() const;
 
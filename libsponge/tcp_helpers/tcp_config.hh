@@ -2,10 +2,15 @@
 #define SPONGE_LIBSPONGE_TCP_CONFIG_HH
 
 #include "address.hh"
+#include "byte_stream.hh"
+#include "congestion_controller.hh"
+#include "stream_reassembler.hh"
+#include "tcp_header.hh"
 #include "wrapping_integers.hh"
 
 #include <cstddef>
 #include <cstdint>
+#include <limits>
 #include <optional>
 
 //! Config for TCP sender and receiver
@@ -13,6 +18,7 @@ class TCPConfig {
   public:
     static constexpr size_t DEFAULT_CAPACITY = 64000;  //!< Default capacity
     static constexpr size_t MAX_PAYLOAD_SIZE = 1452;   //!< Max TCP payload that fits in either IPv4 or UDP datagram
+    static constexpr size_t MAX_OFFLOAD_SIZE = 65536;  //!< Max payload of a segment that the FD adapters split
     static constexpr uint16_t TIMEOUT_DFLT = 1000;     //!< Default re-transmit timeout is 1 second
     static constexpr unsigned MAX_RETX_ATTEMPTS = 8;   //!< Maximum re-transmit attempts before giving up
 
@@ -20,6 +26,55 @@ class TCPConfig {
     size_t recv_capacity = DEFAULT_CAPACITY;  //!< Receive capacity, in bytes
     size_t send_capacity = DEFAULT_CAPACITY;  //!< Sender capacity, in bytes
     std::optional<WrappingInt32> fixed_isn{};
+    //! How the outbound stream stores written data (ByteStream::StorageMode::Chunks avoids copying
+    //! strings moved into TCPConnection::write)
+    ByteStream::StorageMode send_storage = ByteStream::StorageMode::Ring;
+    //! How the receiver holds out-of-order data (StreamReassembler::StorageMode::Slab preallocates
+    //! `recv_capacity` bytes instead of allocating per fragment)
+    StreamReassembler::StorageMode recv_storage = StreamReassembler::StorageMode::Fragments;
+    bool sack = false;  //!< Offer selective acknowledgments (RFC 2018), and use them if the peer agrees
+    //! Offer window scaling (RFC 7323), so that a `recv_capacity` above 65535 bytes can be advertised
+    bool window_scaling = false;
+    //! Offer the timestamps option (RFC 7323), for an RTT sample from every ACK and for protection
+    //! against wrapped sequence numbers (PAWS), and use it if the peer agrees
+    bool timestamps = false;
+    //! Resend the oldest outstanding segment on three duplicate ACKs instead of waiting for the
+    //! retransmission timer (RFC 5681); always on with a congestion control algorithm
+    bool fast_retransmit = false;
+    //! Detect losses by the time that has passed since later data was delivered (RACK, RFC 8985),
+    //! instead of by counting duplicate ACKs once the peer SACKs, and probe for losses at the tail
+    //! of a flight (TLP) about two RTTs after the last new ACK instead of waiting for the RTO
+    bool rack = false;
+    //! Like TCP_NODELAY: send a small segment at once even while data is in flight. Clear it for
+    //! Nagle's algorithm (RFC 896), which holds small segments back until that data is acknowledged
+    bool nodelay = true;
+    //! Delay ACKs of in-order data (RFC 1122): acknowledge every second full-sized segment, or
+    //! `ack_delay` after the first unacknowledged one, unless data going out carries the ACK first
+    bool delayed_ack = false;
+    uint16_t ack_delay = 40;  //!< Longest an ACK may be delayed, in milliseconds (RFC 1122 allows 500)
+    //! Like TCP segmentation offload: send segments of up to MAX_OFFLOAD_SIZE bytes of payload, which
+    //! the FD adapters split into segments of MAX_PAYLOAD_SIZE bytes as they write them
+    bool segmentation_offload = false;
+    //! Like GRO: have TCPSpongeSocket read all the datagrams waiting at once and merge runs of
+    //! in-order segments among them (see TCPSegmentCoalescer) before the TCPConnection sees them
+    bool receive_offload = false;
+    //! Congestion control algorithm for the sender
+    CongestionController::Algorithm congestion_control = CongestionController::Algorithm::None;
+    //! Derive the retransmission timeout from measured round-trip times (RFC 6298), starting
+    //! from `rt_timeout`, instead of always returning to `rt_timeout`
+    bool adaptive_rto = false;
+    uint32_t rto_min = 200;    //!< Smallest adaptive retransmission timeout, in milliseconds
+    uint32_t rto_max = 60000;  //!< Largest adaptive retransmission timeout, after backoff, in milliseconds
+
+    //! The window scale shift to offer: the smallest that fits `recv_capacity` in 16 bits
+    uint8_t window_shift() const {
+        uint8_t shift = 0;
+        while (shift < TCPHeader::MAX_WINDOW_SHIFT and
+               (recv_capacity >> shift) > std::numeric_limits<uint16_t>::max()) {
+            shift++;
+        }
+        return shift;
+    }
 };
 
 //! Config for classes derived from FdAdapter
@@ -30,6 +85,10 @@ class FdAdapterConfig {
 
     uint16_t loss_rate_dn = 0;  //!< Downlink loss rate (for LossyFdAdapter)
     uint16_t loss_rate_up = 0;  //!< Uplink loss rate (for LossyFdAdapter)
+
+    //! Verify the checksum of a data segment's payload as the TCPReceiver copies it into the
+    //! stream, instead of summing it once as it is read and again as it is copied (see TCPSegment::parse)
+    bool defer_payload_checksum = false;
 };
 
 #endif  // SPONGE_LIBSPONGE_TCP_CONFIG_HH
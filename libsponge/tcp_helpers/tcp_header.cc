@@ -1,9 +1,64 @@
 #include "tcp_header.hh"
 
+#include <algorithm>
 #include <sstream>
+#include <string_view>
 
 using namespace std;
 
+//! \name TCP option kinds
+//!@{
+static constexpr uint8_t OPT_END = 0;             //!< End of option list
+static constexpr uint8_t OPT_NOP = 1;             //!< No-operation (padding)
+static constexpr uint8_t OPT_WSCALE = 3;          //!< Window scale, [RFC 7323](\ref rfc::rfc7323)
+static constexpr uint8_t OPT_SACK_PERMITTED = 4;  //!< SACK-permitted, [RFC 2018](\ref rfc::rfc2018)
+static constexpr uint8_t OPT_SACK = 5;            //!< SACK, [RFC 2018](\ref rfc::rfc2018)
+static constexpr uint8_t OPT_TIMESTAMPS = 8;      //!< Timestamps, [RFC 7323](\ref rfc::rfc7323)
+//!@}
+
+//! \param[in] options the options field, as long as `doff` says
+//! \param[out] header receives the options that are understood
+//! \returns TruncatedPacket if an option runs past the end of the field
+static ParseResult parse_options(const string_view options, TCPHeader &header) {
+    size_t i = 0;
+    while (i < options.size()) {
+        const uint8_t kind = NetParser::load_u8(options.data() + i);
+        i++;
+        if (kind == OPT_END) {
+            // anything after the end of the option list is skipped
+            break;
+        }
+        if (kind == OPT_NOP) {
+            continue;
+        }
+
+        if (i == options.size()) {
+            return ParseResult::TruncatedPacket;
+        }
+        const uint8_t option_length = NetParser::load_u8(options.data() + i);
+        if (option_length < 2 or option_length - 1u > options.size() - i) {
+            return ParseResult::TruncatedPacket;
+        }
+        const char *value = options.data() + i + 1;
+        i += option_length - 1u;
+
+        if (kind == OPT_WSCALE and option_length == 3) {
+            header.wscale = NetParser::load_u8(value);
+        } else if (kind == OPT_SACK_PERMITTED and option_length == 2) {
+            header.sack_permitted = true;
+        } else if (kind == OPT_SACK and option_length % 8 == 2) {
+            for (size_t block = 0; block < option_length / 8u; block++) {
+                const WrappingInt32 left{NetParser::load_u32(value + 8 * block)};
+                const WrappingInt32 right{NetParser::load_u32(value + 8 * block + 4)};
+                header.sack.push_back({left, right});
+            }
+        } else if (kind == OPT_TIMESTAMPS and option_length == 10) {
+            header.timestamps = TCPHeader::Timestamps{NetParser::load_u32(value), NetParser::load_u32(value + 4)};
+        }
+    }
+    return ParseResult::NoError;
+}
+
 //! \param[in,out] p is a NetParser from which the TCP fields will be extracted
 //! \returns a ParseResult indicating success or the reason for failure
 //! \details It is important to check for (at least) the following potential errors
@@ -15,66 +70,131 @@ using namespace std;
 //! - there is less data in the header than the `doff` field claims
 //! - the checksum is bad
 ParseResult TCPHeader::parse(NetParser &p) {
-    sport = p.u16();                 // source port
-    dport = p.u16();                 // destination port
-    seqno = WrappingInt32{p.u32()};  // sequence number
-    ackno = WrappingInt32{p.u32()};  // ack number
-    doff = p.u8() >> 4;              // data offset
-
-    const uint8_t fl_b = p.u8();                  // byte including flags
-    urg = static_cast<bool>(fl_b & 0b0010'0000);  // binary literals and ' digit separator since C++14!!!
+    const string_view fixed = p.take(LENGTH);
+    if (p.error()) {
+        return p.get_error();
+    }
+    const char *h = fixed.data();
+
+    sport = NetParser::load_u16(h);                     // source port
+    dport = NetParser::load_u16(h + 2);                 // destination port
+    seqno = WrappingInt32{NetParser::load_u32(h + 4)};  // sequence number
+    ackno = WrappingInt32{NetParser::load_u32(h + 8)};  // ack number
+    doff = NetParser::load_u8(h + 12) >> 4;             // data offset
+
+    const uint8_t fl_b = NetParser::load_u8(h + 13);  // byte including flags
+    urg = static_cast<bool>(fl_b & 0b0010'0000);      // binary literals and ' digit separator since C++14!!!
     ack = static_cast<bool>(fl_b & 0b0001'0000);
     psh = static_cast<bool>(fl_b & 0b0000'1000);
     rst = static_cast<bool>(fl_b & 0b0000'0100);
     syn = static_cast<bool>(fl_b & 0b0000'0010);
     fin = static_cast<bool>(fl_b & 0b0000'0001);
 
-    win = p.u16();    // window size
-    cksum = p.u16();  // checksum
-    uptr = p.u16();   // urgent pointer
+    win = NetParser::load_u16(h + 14);              // window size
+    cksum = NetParser::load_u16(h + CKSUM_OFFSET);  // checksum
+    uptr = NetParser::load_u16(h + 18);             // urgent pointer
 
     if (doff < 5) {
         return ParseResult::HeaderTooShort;
     }
 
-    // skip any options or anything extra in the header
-    p.remove_prefix(doff * 4 - TCPHeader::LENGTH);
-
+    sack_permitted = false;
+    sack.clear();
+    wscale.reset();
+    timestamps.reset();
+    const string_view options = p.take(doff * 4 - TCPHeader::LENGTH);
     if (p.error()) {
         return p.get_error();
     }
 
-    return ParseResult::NoError;
+    return parse_options(options, *this);
 }
 
 //! Serialize the TCPHeader to a string (does not recompute the checksum)
+//! \details Each option is preceded by NOPs so that it ends on a 32-bit boundary. If the
+//! options do not fit in the header length given by `doff`, the serialized `doff` is larger.
 string TCPHeader::serialize() const {
+    string ret(serialized_length(), 0);
+    serialize_into(ret.data());
+    return ret;
+}
+
+//! \returns the number of bytes serialize_into() writes, a multiple of four
+size_t TCPHeader::serialized_length() const {
     // sanity check
     if (doff < 5) {
         throw runtime_error("TCP header too short");
     }
+    if (sack.size() > MAX_SACK_BLOCKS) {
+        throw runtime_error("too many SACK blocks for one TCP header");
+    }
 
-    string ret;
-    ret.reserve(4 * doff);
+    const size_t options_length = (sack_permitted ? 4 : 0) + (wscale.has_value() ? 4 : 0) +
+                                  (timestamps.has_value() ? 12 : 0) + (sack.empty() ? 0 : 4 + 8 * sack.size());
+    if (options_length > MAX_OPTIONS_LENGTH) {
+        throw runtime_error("TCP options too long");
+    }
+    return max<size_t>(4 * doff, LENGTH + options_length);
+}
 
-    NetUnparser::u16(ret, sport);              // source port
-    NetUnparser::u16(ret, dport);              // destination port
-    NetUnparser::u32(ret, seqno.raw_value());  // sequence number
-    NetUnparser::u32(ret, ackno.raw_value());  // ack number
-    NetUnparser::u8(ret, doff << 4);           // data offset
+//! \param[out] out receives the header as serialize() returns it, with the fields at their fixed offsets
+void TCPHeader::serialize_into(char *out) const {
+    const size_t length = serialized_length();
+
+    NetUnparser::u16(out, sport);                  // source port
+    NetUnparser::u16(out + 2, dport);              // destination port
+    NetUnparser::u32(out + 4, seqno.raw_value());  // sequence number
+    NetUnparser::u32(out + 8, ackno.raw_value());  // ack number
+    NetUnparser::u8(out + 12, length / 4 << 4);    // data offset
 
     const uint8_t fl_b = (urg ? 0b0010'0000 : 0) | (ack ? 0b0001'0000 : 0) | (psh ? 0b0000'1000 : 0) |
                          (rst ? 0b0000'0100 : 0) | (syn ? 0b0000'0010 : 0) | (fin ? 0b0000'0001 : 0);
-    NetUnparser::u8(ret, fl_b);  // flags
-    NetUnparser::u16(ret, win);  // window size
+    NetUnparser::u8(out + 13, fl_b);  // flags
+    NetUnparser::u16(out + 14, win);  // window size
 
-    NetUnparser::u16(ret, cksum);  // checksum
+    NetUnparser::u16(out + CKSUM_OFFSET, cksum);  // checksum
 
-    NetUnparser::u16(ret, uptr);  // urgent pointer
+    NetUnparser::u16(out + 18, uptr);  // urgent pointer
 
-    ret.resize(4 * doff);  // expand header to advertised size
+    char *option = out + LENGTH;
+    if (sack_permitted) {
+        NetUnparser::u8(option, OPT_NOP);
+        NetUnparser::u8(option + 1, OPT_NOP);
+        NetUnparser::u8(option + 2, OPT_SACK_PERMITTED);
+        NetUnparser::u8(option + 3, 2);
+        option += 4;
+    }
+    if (wscale.has_value()) {
+        NetUnparser::u8(option, OPT_NOP);
+        NetUnparser::u8(option + 1, OPT_WSCALE);
+        NetUnparser::u8(option + 2, 3);
+        NetUnparser::u8(option + 3, wscale.value());
+        option += 4;
+    }
+    if (timestamps.has_value()) {
+        NetUnparser::u8(option, OPT_NOP);
+        NetUnparser::u8(option + 1, OPT_NOP);
+        NetUnparser::u8(option + 2, OPT_TIMESTAMPS);
+        NetUnparser::u8(option + 3, 10);
+        NetUnparser::u32(option + 4, timestamps->tsval);
+        NetUnparser::u32(option + 8, timestamps->tsecr);
+        option += 12;
+    }
+    if (not sack.empty()) {
+        NetUnparser::u8(option, OPT_NOP);
+        NetUnparser::u8(option + 1, OPT_NOP);
+        NetUnparser::u8(option + 2, OPT_SACK);
+        NetUnparser::u8(option + 3, 2 + 8 * sack.size());
+        option += 4;
+        for (const auto &block : sack) {
+            NetUnparser::u32(option, block.left.raw_value());
+            NetUnparser::u32(option + 4, block.right.raw_value());
+            option += 8;
+        }
+    }
 
-    return ret;
+    // pad to the advertised size
+    fill(option, out + length, static_cast<char>(OPT_END));
 }
 
 //! \returns A string with the header's contents
@@ -90,13 +210,32 @@ string TCPHeader::to_string() const {
        << "TCP winsize: " << +win << '\n'
        << "TCP cksum: " << +cksum << '\n'
        << "TCP uptr: " << +uptr << '\n';
+    if (sack_permitted) {
+        ss << "TCP SACK permitted\n";
+    }
+    if (wscale.has_value()) {
+        ss << "TCP window scale: " << +wscale.value() << '\n';
+    }
+    if (timestamps.has_value()) {
+        ss << "TCP timestamps: " << timestamps->tsval << ' ' << timestamps->tsecr << '\n';
+    }
+    for (const auto &block : sack) {
+        ss << "TCP SACK block: " << block.left << '-' << block.right << '\n';
+    }
     return ss.str();
 }
 
 string TCPHeader::summary() const {
     stringstream ss{};
     ss << "Header(flags=" << (syn ? "S" : "") << (ack ? "A" : "") << (rst ? "R" : "") << (fin ? "F" : "")
-       << ",seqno=" << seqno << ",ack=" << ackno << ",win=" << win << ")";
+       << ",seqno=" << seqno << ",ack=" << ackno << ",win=" << win;
+    for (const auto &block : sack) {
+        ss << ",sack=" << block.left << '-' << block.right;
+    }
+    if (timestamps.has_value()) {
+        ss << ",ts=" << timestamps->tsval << '/' << timestamps->tsecr;
+    }
+    ss << ")";
     return ss.str();
 }
 
@@ -104,5 +243,6 @@ bool TCPHeader::operator==(const TCPHeader &other) const {
     // TODO(aozdemir) more complete check (right now we omit cksum, src, dst
     return seqno == other.seqno && ackno == other.ackno && doff == other.doff && urg == other.urg && ack == other.ack &&
            psh == other.psh && rst == other.rst && syn == other.syn && fin == other.fin && win == other.win &&
-           uptr == other.uptr;
+           uptr == other.uptr && sack_permitted == other.sack_permitted && sack == other.sack &&
+           wscale == other.wscale && timestamps == other.timestamps;
 }
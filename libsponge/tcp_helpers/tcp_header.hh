@@ -4,10 +4,39 @@
 #include "parser.hh"
 #include "wrapping_integers.hh"
 
+#include <optional>
+#include <vector>
+
 //! \brief [TCP](\ref rfc::rfc793) segment header
-//! \note TCP options are not supported
+//! \note Of the TCP options, only SACK-permitted, SACK ([RFC 2018](\ref rfc::rfc2018)), window
+//! scale and timestamps ([RFC 7323](\ref rfc::rfc7323)) are understood; any others are skipped
+//! when parsing.
 struct TCPHeader {
     static constexpr size_t LENGTH = 20;  //!< [TCP](\ref rfc::rfc793) header length, not including options
+    static constexpr size_t MAX_OPTIONS_LENGTH = 40;  //!< Longest options field that `doff` can describe
+    static constexpr size_t MAX_LENGTH = LENGTH + MAX_OPTIONS_LENGTH;  //!< Header length with the most options
+    static constexpr size_t CKSUM_OFFSET = 16;        //!< Offset of the checksum, to fill it in place
+    static constexpr size_t MAX_SACK_BLOCKS = 4;      //!< Most SACK blocks that fit in the options field
+    static constexpr uint8_t MAX_WINDOW_SHIFT = 14;   //!< Largest window scale shift allowed by RFC 7323
+    //! Most SACK blocks that fit in the options field beside a timestamps option
+    static constexpr size_t MAX_SACK_BLOCKS_WITH_TIMESTAMPS = 3;
+
+    //! \brief A block of sequence space held by the receiver beyond its ackno
+    struct SACKBlock {
+        WrappingInt32 left;   //!< first sequence number of the block
+        WrappingInt32 right;  //!< sequence number just past the block
+
+        bool operator==(const SACKBlock &other) const { return left == other.left and right == other.right; }
+    };
+
+    //! \brief The values of a timestamps option
+    struct Timestamps {
+        uint32_t tsval;  //!< the sender's timestamp clock when the segment was sent
+        uint32_t tsecr;  //!< the latest TSval received from the peer (meaningful only with `ack`)
+
+        bool operator==(const Timestamps &other) const { return tsval == other.tsval and tsecr == other.tsecr; }
+        bool operator!=(const Timestamps &other) const { return not(*this == other); }
+    };
 
     //! \struct TCPHeader
     //! ~~~{.txt}
@@ -50,12 +79,26 @@ struct TCPHeader {
     uint16_t uptr = 0;          //!< urgent pointer
     //!@}
 
+    //! \name TCP options
+    //!@{
+    bool sack_permitted = false;             //!< SACK-permitted option (only meaningful on a SYN)
+    std::vector<SACKBlock> sack{};           //!< SACK option blocks, at most MAX_SACK_BLOCKS
+    std::optional<uint8_t> wscale{};         //!< Window scale option: shift count for the sender's windows (SYN only)
+    std::optional<Timestamps> timestamps{};  //!< Timestamps option
+    //!@}
+
     //! Parse the TCP fields from the provided NetParser
     ParseResult parse(NetParser &p);
 
-    //! Serialize the TCP fields
+    //! Serialize the TCP fields, growing `doff` if the options need more room
     std::string serialize() const;
 
+    //! Length of the serialized header: `4 * doff`, or more if the options need more room
+    size_t serialized_length() const;
+
+    //! Serialize the TCP fields into `out`, which must have room for serialized_length() bytes
+    void serialize_into(char *out) const;
+
     //! Return a string containing a header in human-readable format
     std::string to_string() const;
 
@@ -42,7 +42,8 @@ optional<TCPSegment> TCPOverIPv4Adapter::unwrap_tcp_in_ip(const InternetDatagram
 
     // is the payload a valid TCP segment?
     TCPSegment tcp_seg;
-    if (ParseResult::NoError != tcp_seg.parse(ip_dgram.payload(), ip_dgram.header().pseudo_cksum())) {
+    const auto pseudo_cksum = ip_dgram.header().pseudo_cksum();
+    if (ParseResult::NoError != tcp_seg.parse(ip_dgram.payload(), pseudo_cksum, config().defer_payload_checksum)) {
         return {};
     }
 
@@ -81,10 +82,28 @@ InternetDatagram TCPOverIPv4Adapter::wrap_tcp_in_ip(TCPSegment &seg) {
     InternetDatagram ip_dgram;
     ip_dgram.header().src = config().source.ipv4_numeric();
     ip_dgram.header().dst = config().destination.ipv4_numeric();
-    ip_dgram.header().len = ip_dgram.header().hlen * 4 + seg.header().doff * 4 + seg.payload().size();
+    ip_dgram.header().len = ip_dgram.header().hlen * 4 + seg.header_length() + seg.payload().size();
 
     // set payload, calculating TCP checksum using information from IP header
     ip_dgram.payload() = seg.serialize(ip_dgram.header().pseudo_cksum());
 
     return ip_dgram;
 }
+
+//! \param[in,out] seg the segment, which gets the port numbers
+//! \param[out] headers receives the headers in front of anything already in it
+void TCPOverIPv4Adapter::prepend_tcp_in_ip_headers(TCPSegment &seg, HeaderBuffer &headers) {
+    // set the port numbers in the TCP segment
+    seg.header().sport = config().source.port();
+    seg.header().dport = config().destination.port();
+
+    IPv4Header ip_header;
+    ip_header.src = config().source.ipv4_numeric();
+    ip_header.dst = config().destination.ipv4_numeric();
+    const size_t tcp_header_length = seg.header_length();
+    ip_header.len = ip_header.hlen * 4 + tcp_header_length + seg.payload().size();
+
+    // the TCP header first, then the IP header in front of it
+    seg.serialize_header_into(headers.prepend(tcp_header_length), ip_header.pseudo_cksum());
+    ip_header.serialize_into(headers.prepend(ip_header.hlen * 4), true);
+}
@@ -11,9 +11,16 @@
 //! \brief A converter from TCP segments to serialized IPv4 datagrams
 class TCPOverIPv4Adapter : public FdAdapterBase {
   public:
+    //! Room for the IPv4 and TCP headers of one datagram
+    using HeaderBuffer = HeadroomBuffer<IPv4Header::MAX_LENGTH + TCPHeader::MAX_LENGTH>;
+
     std::optional<TCPSegment> unwrap_tcp_in_ip(const InternetDatagram &ip_dgram);
 
     InternetDatagram wrap_tcp_in_ip(TCPSegment &seg);
+
+    //! \brief Prepend the IPv4 and TCP headers that carry `seg` to `headers`, as wrap_tcp_in_ip()
+    //! would serialize them; the datagram is `headers` followed by the payload
+    void prepend_tcp_in_ip_headers(TCPSegment &seg, HeaderBuffer &headers);
 };
 
 #endif  // SPONGE_LIBSPONGE_TCP_OVER_IP_HH
@@ -3,23 +3,43 @@
 #include "parser.hh"
 #include "util.hh"
 
+#include <algorithm>
 #include <variant>
 
 using namespace std;
 
 //! \param[in] buffer string/Buffer to be parsed
 //! \param[in] datagram_layer_checksum pseudo-checksum from the lower-layer protocol
-ParseResult TCPSegment::parse(const Buffer buffer, const uint32_t datagram_layer_checksum) {
-    InternetChecksum check(datagram_layer_checksum);
-    check.add(buffer);
-    if (check.value()) {
-        return ParseResult::BadChecksum;
+//! \param[in] defer_payload_checksum leave the payload of a data segment to be summed by its receiver
+ParseResult TCPSegment::parse(const Buffer buffer,
+                              const uint32_t datagram_layer_checksum,
+                              const bool defer_payload_checksum) {
+    _deferred_checksum.reset();
+
+    if (not defer_payload_checksum) {
+        InternetChecksum check(datagram_layer_checksum);
+        check.add(buffer);
+        if (check.value()) {
+            return ParseResult::BadChecksum;
+        }
     }
 
     NetParser p{buffer};
     _header.parse(p);
     _payload = p.buffer();
-    return p.get_error();
+    if (p.error() or not defer_payload_checksum) {
+        return p.get_error();
+    }
+
+    InternetChecksum check(datagram_layer_checksum);
+    check.add(buffer.str().substr(0, buffer.size() - _payload.size()));
+    if (_payload.size() > 0 and not _header.syn and not _header.fin and not _header.rst) {
+        _deferred_checksum = check;
+        return ParseResult::NoError;
+    }
+
+    check.add(_payload);
+    return check.value() ? ParseResult::BadChecksum : ParseResult::NoError;
 }
 
 size_t TCPSegment::length_in_sequence_space() const {
@@ -28,18 +48,83 @@ size_t TCPSegment::length_in_sequence_space() const {
 
 //! \param[in] datagram_layer_checksum pseudo-checksum from the lower-layer protocol
 BufferList TCPSegment::serialize(const uint32_t datagram_layer_checksum) const {
-    TCPHeader header_out = _header;
-    header_out.cksum = 0;
+    string header(header_length(), 0);
+    serialize_header_into(header.data(), datagram_layer_checksum);
+
+    BufferList ret;
+    ret.append(move(header));
+    ret.append(_payload);
+
+    return ret;
+}
+
+//! \param[out] out receives the header
+//! \param[in] datagram_layer_checksum pseudo-checksum from the lower-layer protocol
+void TCPSegment::serialize_header_into(char *out, const uint32_t datagram_layer_checksum) const {
+    const size_t length = header_length();
+    _header.serialize_into(out);
+    NetUnparser::u16(out + TCPHeader::CKSUM_OFFSET, 0);
 
     // calculate checksum -- taken over entire segment
     InternetChecksum check(datagram_layer_checksum);
-    check.add(header_out.serialize());
+    check.add({out, length});
+    const bool summed = _summed_payload.str().data() == _payload.str().data() and
+                        _summed_payload.size() == _payload.size();
+    if (summed) {
+        check.add(_payload_sum);
+    } else {
+        check.add(_payload);
+    }
+    NetUnparser::u16(out + TCPHeader::CKSUM_OFFSET, check.value());
+}
+
+void TCPSegment::sum_payload() {
+    _payload_sum = InternetChecksum{};
+    _payload_sum.add(_payload);
+    _summed_payload = _payload;
+}
+
+//! \param[in] payload the new payload
+//! \param[in] payload_sum the sum of `payload` alone, from an even offset
+void TCPSegment::set_payload(Buffer payload, const InternetChecksum &payload_sum) {
+    _payload = move(payload);
+    _payload_sum = payload_sum;
+    _summed_payload = _payload;
+}
+
+bool TCPSegment::verify_deferred_checksum() const {
+    if (not _deferred_checksum.has_value()) {
+        return true;
+    }
+    InternetChecksum check = _deferred_checksum.value();
     check.add(_payload);
-    header_out.cksum = check.value();
+    return check.value() == 0;
+}
 
-    BufferList ret;
-    ret.append(header_out.serialize());
-    ret.append(_payload);
+//! \details Each piece carries a copy of the header, with the seqno of its first byte; the SYN
+//! stays on the first piece and the FIN on the last. The pieces share the payload's storage.
+//! \param[in] max_payload the most payload bytes in each piece
+vector<TCPSegment> TCPSegment::split(const size_t max_payload) const {
+    vector<TCPSegment> pieces;
+    const size_t size = _payload.size();
+    if (size <= max_payload) {
+        pieces.push_back(*this);
+        return pieces;
+    }
 
-    return ret;
+    pieces.reserve((size + max_payload - 1) / max_payload);
+    for (size_t offset = 0; offset < size; offset += max_payload) {
+        const size_t end = min(size, offset + max_payload);
+        TCPSegment &piece = pieces.emplace_back(*this);
+        if (offset > 0) {
+            piece.header().seqno = _header.seqno + static_cast<uint32_t>(offset + (_header.syn ? 1 : 0));
+            piece.header().syn = false;
+        }
+        if (end < size) {
+            piece.header().fin = false;
+        }
+        piece.payload().remove_prefix(offset);
+        piece.payload().remove_suffix(size - end);
+    }
+    return pieces;
 }
@@ -3,8 +3,11 @@
 
 #include "buffer.hh"
 #include "tcp_header.hh"
+#include "util.hh"
 
 #include <cstdint>
+#include <optional>
+#include <vector>
 
 //! \brief [TCP](\ref rfc::rfc793) segment
 class TCPSegment {
@@ -12,13 +15,57 @@ class TCPSegment {
     TCPHeader _header{};
     Buffer _payload{};
 
+    //! The sum of the payload as it was when sum_payload() was called, and that payload, which
+    //! keeps its storage from being reused by another payload at the same address
+    InternetChecksum _payload_sum{};
+    Buffer _summed_payload{};
+
+    //! The sum of everything the checksum covers but the payload, if parse() deferred the rest
+    std::optional<InternetChecksum> _deferred_checksum{};
+
   public:
     //! \brief Parse the segment from a string
-    ParseResult parse(const Buffer buffer, const uint32_t datagram_layer_checksum = 0);
+    //! \details With `defer_payload_checksum`, a segment carrying data and none of SYN, FIN or RST
+    //! (which TCPConnection acts on before the payload reaches the TCPReceiver) only has its header
+    //! summed here. The payload is summed where the receiver copies it into the stream, so its
+    //! bytes are read once; see deferred_checksum().
+    ParseResult parse(const Buffer buffer,
+                      const uint32_t datagram_layer_checksum = 0,
+                      const bool defer_payload_checksum = false);
 
     //! \brief Serialize the segment to a string
+    //! \note Only the header is summed if the payload has not changed since sum_payload()
     BufferList serialize(const uint32_t datagram_layer_checksum = 0) const;
 
+    //! \brief Serialize the header, with the checksum of the whole segment, into `out`, which must
+    //! have room for header_length() bytes; the payload follows it on the wire as it is
+    void serialize_header_into(char *out, const uint32_t datagram_layer_checksum = 0) const;
+
+    //! \brief Length of the serialized header, options included
+    size_t header_length() const { return _header.serialized_length(); }
+
+    //! \brief Sum the payload now, so that this segment and its copies can be serialized again
+    //! after header changes (a new ackno, a retransmission) without summing it again
+    void sum_payload();
+
+    //! \brief Set the payload together with its sum, e.g. taken while it was copied out of a ByteStream
+    void set_payload(Buffer payload, const InternetChecksum &payload_sum);
+
+    //! \name Checksum deferred by parse()
+    //!@{
+
+    //! The sum of the pseudo-header and the header, if the payload still has to be added to it to
+    //! verify the checksum (the segment may be corrupt until then)
+    const std::optional<InternetChecksum> &deferred_checksum() const { return _deferred_checksum; }
+
+    //! \brief Sum the payload to finish a deferred checksum
+    //! \returns `true` if the checksum is correct, or was not deferred
+    bool verify_deferred_checksum() const;
+    //!@}
+
+    //! \brief Split the segment into segments with at most `max_payload` bytes of payload each
+    std::vector<TCPSegment> split(const size_t max_payload) const;
+
     //! \name Accessors
     //!@{
     const TCPHeader &header() const { return _header; }
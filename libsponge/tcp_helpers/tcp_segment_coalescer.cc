@@ -0,0 +1,67 @@
+#include "tcp_segment_coalescer.hh"
+
+using namespace std;
+
+bool TCPSegmentCoalescer::continues(const TCPSegment &seg) const {
+    if (not _run.has_value()) {
+        return false;
+    }
+
+    const TCPHeader &run = _run->header();
+    const TCPHeader &next = seg.header();
+
+    // only data continues data, and nothing follows a FIN
+    if (_payload.size() == 0 or seg.payload().size() == 0 or run.fin) {
+        return false;
+    }
+    if (run.syn or run.rst or run.urg or next.syn or next.rst or next.urg) {
+        return false;
+    }
+    // a segment that may still turn out to be corrupt is handed on alone, not with a whole run
+    if (_run->deferred_checksum().has_value() or seg.deferred_checksum().has_value()) {
+        return false;
+    }
+
+    // the payload must start exactly where the run's ends
+    if (next.seqno != run.seqno + static_cast<uint32_t>(_payload.size())) {
+        return false;
+    }
+
+    // the same acknowledgment and options
+    if (next.ack != run.ack or next.ackno != run.ackno or next.sack != run.sack or
+        next.timestamps != run.timestamps) {
+        return false;
+    }
+
+    return _payload.size() + seg.payload().size() <= _max_payload;
+}
+
+//! \param[in] seg is the segment just received
+optional<TCPSegment> TCPSegmentCoalescer::push(TCPSegment &&seg) {
+    if (continues(seg)) {
+        _payload.append(seg.payload());
+        _run->header().win = seg.header().win;
+        _run->header().fin = seg.header().fin;
+        _run->header().psh |= seg.header().psh;
+        return {};
+    }
+
+    optional<TCPSegment> ended = flush();
+    _payload = seg.payload();
+    _run = move(seg);
+    return ended;
+}
+
+optional<TCPSegment> TCPSegmentCoalescer::flush() {
+    if (not _run.has_value()) {
+        return {};
+    }
+
+    optional<TCPSegment> merged = move(_run);
+    _run.reset();
+    if (_payload.buffers().size() > 1) {
+        merged->payload() = Buffer{_payload.concatenate()};
+    }
+    _payload = {};
+    return merged;
+}
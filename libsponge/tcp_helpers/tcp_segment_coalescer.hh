@@ -0,0 +1,40 @@
+#ifndef SPONGE_LIBSPONGE_TCP_SEGMENT_COALESCER_HH
+#define SPONGE_LIBSPONGE_TCP_SEGMENT_COALESCER_HH
+
+#include "buffer.hh"
+#include "tcp_config.hh"
+#include "tcp_segment.hh"
+
+#include <cstddef>
+#include <optional>
+
+//! \brief Receive offload: merges runs of consecutive in-order segments into one segment
+//!
+//! Like GRO, a segment only joins the run before it if both carry data, its payload starts where
+//! the run's ends, and it agrees with the run on everything but the seqno and window: the same
+//! ACK and options, and no SYN, RST or URG. A FIN ends a run. The merged segment has the window of
+//! the latest segment in the run, so the ACK state it leaves behind is that of the whole run.
+class TCPSegmentCoalescer {
+  private:
+    std::optional<TCPSegment> _run{};  //!< The first segment of the current run, if there is one
+    BufferList _payload{};             //!< The payload of the run so far
+    size_t _max_payload;               //!< Longest payload of a merged segment
+
+    //! Does `seg` continue the current run?
+    bool continues(const TCPSegment &seg) const;
+
+  public:
+    //! \param[in] max_payload is the longest payload a merged segment may have
+    explicit TCPSegmentCoalescer(const size_t max_payload = TCPConfig::MAX_OFFLOAD_SIZE)
+        : _max_payload(max_payload) {}
+
+    //! \brief Add a segment, merging it into the current run if it continues it
+    //! \returns the run that `seg` ended, if it didn't continue it
+    std::optional<TCPSegment> push(TCPSegment &&seg);
+
+    //! \brief End the current run
+    //! \returns the merged segment, if there was a run
+    std::optional<TCPSegment> flush();
+};
+
+#endif  // SPONGE_LIBSPONGE_TCP_SEGMENT_COALESCER_HH
@@ -2,12 +2,14 @@
 
 #include "network_interface.hh"
 #include "parser.hh"
+#include "tcp_segment_coalescer.hh"
 #include "tun.hh"
 #include "util.hh"
 
 #include <cstddef>
 #include <exception>
 #include <iostream>
+#include <poll.h>
 #include <stdexcept>
 #include <string>
 #include <sys/socket.h>
@@ -20,6 +22,15 @@ using namespace std;
 
 static constexpr size_t TCP_TICK_MS = 10;
 
+//! Most datagrams read at once with receive offload, so that outbound work is not starved
+static constexpr size_t RECEIVE_OFFLOAD_BATCH = 64;
+
+//! \returns `true` if a read from `fd` would not block
+static bool readable(const FileDescriptor &fd) {
+    pollfd pfd{fd.fd_num(), POLLIN, 0};
+    return SystemCall("poll", ::poll(&pfd, 1, 0)) > 0 and (pfd.revents & POLLIN);
+}
+
 //! \param[in] condition is a function returning true if loop should continue
 template <typename AdaptT>
 void TCPSpongeSocket<AdaptT>::_tcp_loop(const function<bool()> &condition) {
@@ -50,9 +61,42 @@ TCPSpongeSocket<AdaptT>::TCPSpongeSocket(pair<FileDescriptor, FileDescriptor> da
     _thread_data.set_blocking(false);
 }
 
+//! \details With receive offload, this reads every datagram already waiting, up to RECEIVE_OFFLOAD_BATCH,
+//! and merges runs of in-order segments among them with a TCPSegmentCoalescer. The TCPConnection then
+//! handles, and acknowledges, each run as a single segment.
+template <typename AdaptT>
+void TCPSpongeSocket<AdaptT>::_receive_segments() {
+    if (not _receive_offload) {
+        auto seg = _datagram_adapter.read();
+        if (seg) {
+            _tcp->segment_received(move(seg.value()));
+        }
+        return;
+    }
+
+    TCPSegmentCoalescer coalescer;
+    size_t datagrams_read = 0;
+    do {
+        auto seg = _datagram_adapter.read();
+        datagrams_read++;
+        if (seg) {
+            auto run = coalescer.push(move(seg.value()));
+            if (run) {
+                _tcp->segment_received(move(run.value()));
+            }
+        }
+    } while (datagrams_read < RECEIVE_OFFLOAD_BATCH and readable(_datagram_adapter));
+
+    auto run = coalescer.flush();
+    if (run) {
+        _tcp->segment_received(move(run.value()));
+    }
+}
+
 template <typename AdaptT>
 void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
     _tcp.emplace(config);
+    _receive_offload = config.receive_offload;
 
     // Set up the event loop
 
@@ -76,10 +120,7 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
     _eventloop.add_rule(_datagram_adapter,
                         Direction::In,
                         [&] {
-                            auto seg = _datagram_adapter.read();
-                            if (seg) {
-                                _tcp->segment_received(move(seg.value()));
-                            }
+                            _receive_segments();
 
                             // debugging output:
                             if (_thread_data.eof() and _tcp.value().bytes_in_flight() == 0 and not _fully_acked) {
@@ -96,7 +137,7 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
         _thread_data,
         Direction::In,
         [&] {
-            const auto data = _thread_data.read(_tcp->remaining_outbound_capacity());
+            auto data = _thread_data.read(_tcp->remaining_outbound_capacity());
             const auto len = data.size();
             const auto amount_written = _tcp->write(move(data));
             if (amount_written != len) {
@@ -129,8 +170,7 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
             // the pipe, handling the possibility of a partial
             // write (i.e., only pop what was actually written).
             const size_t amount_to_write = min(size_t(65536), inbound.buffer_size());
-            const std::string buffer = inbound.peek_output(amount_to_write);
-            const auto bytes_written = _thread_data.write(move(buffer), false);
+            const auto bytes_written = _thread_data.write(inbound.peek_views(amount_to_write), false);
             inbound.pop_output(bytes_written);
 
             if (inbound.eof() or inbound.error()) {
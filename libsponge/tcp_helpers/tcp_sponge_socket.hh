@@ -55,6 +55,11 @@ class TCPSpongeSocket : public LocalStreamSocket {
 
     bool _fully_acked{false};  //!< Has the outbound data been fully acknowledged by the peer?
 
+    bool _receive_offload{false};  //!< Merge in-order segments read together (TCPConfig::receive_offload)?
+
+    //! Read a datagram, or with receive offload all those waiting, and give the segments to the TCPConnection
+    void _receive_segments();
+
   public:
     //! Construct from the interface that the TCPConnection thread will use to read and write datagrams
     explicit TCPSpongeSocket(AdaptT &&datagram_interface);
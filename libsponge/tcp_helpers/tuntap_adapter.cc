@@ -44,7 +44,13 @@ void TCPOverIPv4OverEthernetAdapter::tick(const size_t ms_since_last_tick) {
 
 //! \param[in] seg the TCPSegment to send
 void TCPOverIPv4OverEthernetAdapter::write(TCPSegment &seg) {
-    _interface.send_datagram(wrap_tcp_in_ip(seg), _next_hop);
+    if (seg.payload().size() <= TCPConfig::MAX_PAYLOAD_SIZE) {
+        _interface.send_datagram(wrap_tcp_in_ip(seg), _next_hop);
+    } else {
+        for (TCPSegment &piece : seg.split(TCPConfig::MAX_PAYLOAD_SIZE)) {
+            _interface.send_datagram(wrap_tcp_in_ip(piece), _next_hop);
+        }
+    }
     send_pending();
 }
 
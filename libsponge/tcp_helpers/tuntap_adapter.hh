@@ -3,6 +3,7 @@
 
 #include "ethernet_header.hh"
 #include "network_interface.hh"
+#include "tcp_config.hh"
 #include "tun.hh"
 
 #include <optional>
@@ -14,6 +15,15 @@ class TCPOverIPv4OverTunFdAdapter : public TCPOverIPv4Adapter {
   private:
     TunFD _tun;
 
+    //! Writes one TCP segment in an IPv4 datagram, its headers built on the stack in front of the payload
+    void write_datagram(TCPSegment &seg) {
+        HeaderBuffer headers;
+        prepend_tcp_in_ip_headers(seg, headers);
+        BufferViewList datagram{headers.str()};
+        datagram.append(seg.payload().str());
+        _tun.write(std::move(datagram));
+    }
+
   public:
     //! Construct from a TunFD
     explicit TCPOverIPv4OverTunFdAdapter(TunFD &&tun) : _tun(std::move(tun)) {}
@@ -28,7 +38,16 @@ class TCPOverIPv4OverTunFdAdapter : public TCPOverIPv4Adapter {
     }
 
     //! Creates an IPv4 datagram from a TCP segment and writes it to the TUN device
-    void write(TCPSegment &seg) { _tun.write(wrap_tcp_in_ip(seg).serialize()); }
+    //! \note A segment with more than TCPConfig::MAX_PAYLOAD_SIZE bytes of payload is split first
+    void write(TCPSegment &seg) {
+        if (seg.payload().size() <= TCPConfig::MAX_PAYLOAD_SIZE) {
+            write_datagram(seg);
+            return;
+        }
+        for (TCPSegment &piece : seg.split(TCPConfig::MAX_PAYLOAD_SIZE)) {
+            write_datagram(piece);
+        }
+    }
 
     //! Access the underlying TUN device
     operator TunFD &() { return _tun; }
@@ -60,7 +79,7 @@ class TCPOverIPv4OverEthernetAdapter : public TCPOverIPv4Adapter {
     //! Attempts to read and parse an Ethernet frame containing an IPv4 datagram that contains a TCP segment
     std::optional<TCPSegment> read();
 
-    //! Sends a TCP segment (in an IPv4 datagram, in an Ethernet frame).
+    //! Sends a TCP segment (in an IPv4 datagram, in an Ethernet frame), split as in TCPOverIPv4OverTunFdAdapter
     void write(TCPSegment &seg);
 
     //! Called periodically when time elapses
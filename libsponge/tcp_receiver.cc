@@ -2,25 +2,52 @@
 
 using namespace std;
 
-void TCPReceiver::segment_received(const TCPSegment &seg) {
+bool TCPReceiver::segment_received(const TCPSegment &seg) {
+    if (outdated(seg))
+        return true;
+
     // Set syn, if flagged
     if (seg.header().syn) {
         _syn_set = true;
         _isn = seg.header().seqno;
+        if (_timestamps and seg.header().timestamps.has_value())
+            _ts_recent = seg.header().timestamps->tsval;
         // When syn is set, the seqno begin with SYN, so need treat specially
-        _reassembler.push_substring(seg.payload().copy(), 0, seg.header().fin);
-        return;
+        _reassembler.push_substring(seg.payload(), 0, seg.header().fin);
+        return true;
     }
 
     // If syn is not set, just ignore whole segment
     if (!_syn_set)
-        return;
+        return true;
 
     // Calculate index unwrap checkpoint
     uint64_t checkpoint = _reassembler.stream_out().bytes_read() + _reassembler.stream_out().buffer_size() + 1;
     // Calculate index where the segment start
     uint64_t stream_index = unwrap(seg.header().seqno, _isn, checkpoint) - 1;
-    _reassembler.push_substring(seg.payload().copy(), stream_index, seg.header().fin);
+    // a deferred checksum is verified first, as the payload is copied
+    if (seg.deferred_checksum().has_value()) {
+        if (not _reassembler.push_substring(
+                seg.payload(), stream_index, seg.header().fin, seg.deferred_checksum().value()))
+            return false;
+    } else {
+        _reassembler.push_substring(seg.payload(), stream_index, seg.header().fin);
+    }
+    // only a segment that begins at or before the ackno updates the timestamp to echo
+    if (_ts_recent.has_value() and seg.header().timestamps.has_value() and stream_index + 1 <= checkpoint)
+        _ts_recent = seg.header().timestamps->tsval;
+
+    if (seg.payload().size() > 0 and stream_index > _reassembler.stream_out().bytes_written()) {
+        _latest_out_of_order = stream_index;
+    }
+    return true;
+}
+
+bool TCPReceiver::outdated(const TCPSegment &seg) const {
+    if (seg.header().rst or not seg.header().timestamps.has_value() or not _ts_recent.has_value())
+        return false;
+    // timestamps are compared modulo 2^32
+    return static_cast<int32_t>(seg.header().timestamps->tsval - _ts_recent.value()) < 0;
 }
 
 optional<WrappingInt32> TCPReceiver::ackno() const {
@@ -34,3 +61,32 @@ optional<WrappingInt32> TCPReceiver::ackno() const {
 size_t TCPReceiver::window_size() const {
     return _syn_set ? _capacity - _reassembler.stream_out().buffer_size() : _capacity;
 }
+
+vector<TCPHeader::SACKBlock> TCPReceiver::sack_blocks(const size_t limit) const {
+    vector<TCPHeader::SACKBlock> blocks;
+    if (not _syn_set or limit == 0 or _reassembler.empty()) {
+        return blocks;
+    }
+
+    // stream index i is sequence number i + 1, after the SYN
+    const auto to_block = [&](const StreamReassembler::Range &range) {
+        return TCPHeader::SACKBlock{wrap(range.first + 1, _isn), wrap(range.second + 1, _isn)};
+    };
+
+    optional<StreamReassembler::Range> latest;
+    if (_latest_out_of_order.has_value()) {
+        latest = _reassembler.buffered_range_containing(_latest_out_of_order.value());
+    }
+    if (latest.has_value()) {
+        blocks.push_back(to_block(latest.value()));
+    }
+    for (const auto &range : _reassembler.buffered_ranges(limit)) {
+        if (blocks.size() == limit) {
+            break;
+        }
+        if (range != latest) {
+            blocks.push_back(to_block(range));
+        }
+    }
+    return blocks;
+}
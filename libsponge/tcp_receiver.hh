@@ -6,7 +6,9 @@
 #include "tcp_segment.hh"
 #include "wrapping_integers.hh"
 
+#include <cstdint>
 #include <optional>
+#include <vector>
 
 //! \brief The "receiver" part of a TCP implementation.
 
@@ -23,13 +25,24 @@ class TCPReceiver {
     bool _syn_set{false};
     //! Initial sequence number
     WrappingInt32 _isn{0};
+    //! Stream index of the most recent segment that arrived out of order
+    std::optional<uint64_t> _latest_out_of_order{};
+    //! Did our SYN offer timestamps?
+    bool _timestamps;
+    //! The timestamp to echo to the peer (TS.Recent), once both SYNs have offered timestamps
+    std::optional<uint32_t> _ts_recent{};
 
   public:
     //! \brief Construct a TCP receiver
     //!
     //! \param capacity the maximum number of bytes that the receiver will
     //!                 store in its buffers at any give time.
-    TCPReceiver(const size_t capacity) : _reassembler(capacity), _capacity(capacity) {}
+    //! \param storage how the reassembler holds out-of-order data
+    //! \param timestamps whether our SYN offers the timestamps option ([RFC 7323](\ref rfc::rfc7323))
+    TCPReceiver(const size_t capacity,
+                const StreamReassembler::StorageMode storage = StreamReassembler::StorageMode::Fragments,
+                const bool timestamps = false)
+        : _reassembler(capacity, storage), _capacity(capacity), _timestamps(timestamps) {}
 
     //! \name Accessors to provide feedback to the remote TCPSender
     //!@{
@@ -52,13 +65,38 @@ class TCPReceiver {
     //! accepted by the receiver) and (b) the sequence number of the
     //! beginning of the window (the ackno).
     size_t window_size() const;
+
+    //! \brief The SACK blocks that should be sent to the peer ([RFC 2018](\ref rfc::rfc2018))
+    //!
+    //! The first block holds the most recently received out-of-order segment; the rest
+    //! are the lowest other blocks of data held beyond the ackno.
+    //! \param limit the most blocks to return
+    std::vector<TCPHeader::SACKBlock> sack_blocks(const size_t limit = TCPHeader::MAX_SACK_BLOCKS) const;
+
+    //! \brief The timestamp to echo to the peer as TSecr ([RFC 7323](\ref rfc::rfc7323))
+    //! \returns empty unless both SYNs offered timestamps
+    //!
+    //! This is the TSval of the latest in-sequence segment, or of the segment that filled the
+    //! hole at the ackno, so that delayed and lost segments inflate the peer's RTT samples
+    //! rather than hide them.
+    std::optional<uint32_t> ts_recent() const { return _ts_recent; }
     //!@}
 
+    //! \brief Does `seg` carry a timestamp older than ts_recent()?
+    //!
+    //! Such a segment is an old duplicate, possibly from a previous wrap of the sequence space.
+    //! Its contents are dropped, but it must still be acknowledged (PAWS, [RFC 7323](\ref rfc::rfc7323)).
+    //! Always false unless both SYNs offered timestamps.
+    bool outdated(const TCPSegment &seg) const;
+
     //! \brief number of bytes stored but not yet reassembled
     size_t unassembled_bytes() const { return _reassembler.unassembled_bytes(); }
 
     //! \brief handle an inbound segment
-    void segment_received(const TCPSegment &seg);
+    //! \details A segment whose checksum parse() deferred is verified as its payload is copied
+    //! into the stream, and is ignored if it turns out to be corrupt.
+    //! \returns `false` if the segment was ignored as corrupt
+    bool segment_received(const TCPSegment &seg);
 
     //! \name "Output" interface for the reader
     //!@{
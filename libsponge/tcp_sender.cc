@@ -3,6 +3,8 @@
 #include "tcp_config.hh"
 #include "wrapping_integers.hh"
 
+#include <algorithm>
+#include <cmath>
 #include <cstddef>
 #include <random>
 
@@ -17,97 +19,496 @@ TCPSender::TCPSender(const size_t capacity, const uint16_t retx_timeout, const s
     , _rto(retx_timeout)
     , _stream(capacity) {}
 
+//! \param[in] cfg the configuration; uses `send_capacity`, `rt_timeout`, `fixed_isn`, `send_storage`,
+//! `nodelay`, `fast_retransmit`, `rack`, `congestion_control`, `adaptive_rto`, `rto_min` and `rto_max`
+TCPSender::TCPSender(const TCPConfig &cfg)
+    : _isn(cfg.fixed_isn.value_or(WrappingInt32{random_device()()}))
+    , _congestion(CongestionController::create(cfg.congestion_control, TCPConfig::MAX_PAYLOAD_SIZE))
+    , _fast_retransmit(cfg.fast_retransmit or _congestion != nullptr)
+    , _rack(cfg.rack)
+    , _initial_retransmission_timeout{cfg.rt_timeout}
+    , _rto(cfg.rt_timeout)
+    , _adaptive_rto(cfg.adaptive_rto)
+    , _rto_min(cfg.rto_min)
+    , _rto_max(cfg.rto_max)
+    , _nodelay(cfg.nodelay)
+    , _max_payload_size(cfg.segmentation_offload ? TCPConfig::MAX_OFFLOAD_SIZE : TCPConfig::MAX_PAYLOAD_SIZE)
+    , _stream(cfg.send_capacity, cfg.send_storage) {}
+
 uint64_t TCPSender::bytes_in_flight() const { return _next_seqno - _ack_seqno; }
 
+uint64_t TCPSender::send_window() const {
+    // When window size claims to be zero, treat as 1
+    const uint64_t window = max(_window_size, uint64_t{1});
+    return _congestion ? min(window, _congestion->window()) : window;
+}
+
 void TCPSender::fill_window() {
+    const optional<double> rate = pacing_rate();
     while (1) {
+        // a paced sender waits for credit before releasing new data
+        if (rate.has_value() and _pacing_credit <= 0)
+            return;
+
         // new segment
         TCPSegment new_segment{};
         new_segment.header().seqno = WrappingInt32{wrap(_next_seqno, _isn)};
 
-        // When window size claims to be zero, treat as 1
-        size_t max_bytes_to_send = min(max(_window_size, 1ul) + _ack_seqno - _next_seqno, TCPConfig::MAX_PAYLOAD_SIZE);
+        // the window may have shrunk below what is already in flight
+        const uint64_t window = send_window();
+        const uint64_t free_space = window > bytes_in_flight() ? window - bytes_in_flight() : 0;
+        // a paced sender releases at most an MSS at a time, even with segmentation offload
+        size_t max_bytes_to_send = min(free_space, rate.has_value() ? TCPConfig::MAX_PAYLOAD_SIZE : _max_payload_size);
+
+        // Nagle: a small segment waits until nothing is in flight
+        if (not _nodelay and _next_seqno > 0 and bytes_in_flight() > 0 and not _stream.input_ended() and
+            min(max_bytes_to_send, _stream.buffer_size()) < TCPConfig::MAX_PAYLOAD_SIZE)
+            return;
+
         if (_next_seqno == 0) {
             // first segment
             new_segment.header().syn = true;
         } else {
-            new_segment.payload() = Buffer{_stream.read(max_bytes_to_send)};
+            // the payload is summed as it is read, so the outstanding copy and its retransmissions share the sum
+            InternetChecksum payload_sum;
+            const BufferList payload = _stream.read_buffers(max_bytes_to_send, payload_sum);
+            new_segment.set_payload(payload.buffers().size() > 1 ? Buffer{payload.concatenate()} : Buffer{payload},
+                                    payload_sum);
         }
 
         // stream eof
         if (_stream.eof() && _next_seqno < _stream.bytes_written() + 2 &&
-            new_segment.length_in_sequence_space() + 1 <= max(_window_size, 1ul) + _ack_seqno - _next_seqno)
+            new_segment.length_in_sequence_space() + 1 <= free_space)
             new_segment.header().fin = true;
 
         // nothing to send, abort
         if (new_segment.length_in_sequence_space() == 0)
             return;
 
-        _segments_out.push(new_segment);
-        _segments_outstanding.push_back(new_segment);
-        _next_seqno += new_segment.length_in_sequence_space();
+        // nothing was in flight, so the next delivery rate interval starts now
+        if (_segments_outstanding.empty()) {
+            _first_sent_time = _time;
+            _delivered_time = _time;
+        }
+
+        // the outstanding copy shares the payload and its sum; the original moves on to the connection.
+        // An offloaded segment goes out whole, but each MSS of it is acknowledged and resent on its own.
+        const size_t length = new_segment.length_in_sequence_space();
+        const Transmission transmission{_time, _first_sent_time, _delivered, _delivered_time, 1};
+        if (new_segment.payload().size() <= TCPConfig::MAX_PAYLOAD_SIZE) {
+            _segments_outstanding.push(_next_seqno, new_segment, transmission);
+        } else {
+            uint64_t seqno = _next_seqno;
+            for (TCPSegment &piece : new_segment.split(TCPConfig::MAX_PAYLOAD_SIZE)) {
+                // a piece is only serialized to be resent; its sum is taken now so that this costs O(header)
+                piece.sum_payload();
+                const size_t piece_length = piece.length_in_sequence_space();
+                _segments_outstanding.push(seqno, move(piece), transmission);
+                seqno += piece_length;
+            }
+        }
+        _segments_out.push(move(new_segment));
+        _next_seqno += length;
+        if (rate.has_value())
+            _pacing_credit -= length;
 
         // start timer if stopped
         if (_timer.state == TimerState::Stop) {
             _timer.state = TimerState::Running;
             _timer.start_time = _time;
         }
+
+        // new data restarts the loss probe timer
+        arm_tlp();
     };
 }
 
 //! \param ackno The remote receiver's ackno (acknowledgment number)
-//! \param window_size The remote receiver's advertised window size
-void TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_size) {
+//! \param window_size The remote receiver's advertised window size, in bytes
+//! \param sack_blocks The SACK blocks the remote receiver reported, if any
+//! \param pure_ack Whether the ACK arrived in a segment that occupies no sequence numbers
+//! \param echoed_timestamp The timestamp the remote receiver echoed (TSecr), if any
+void TCPSender::ack_received(const WrappingInt32 ackno,
+                             const uint64_t window_size,
+                             const vector<TCPHeader::SACKBlock> &sack_blocks,
+                             const bool pure_ack,
+                             const optional<uint32_t> echoed_timestamp) {
+    const uint64_t abs_ackno = unwrap(ackno, _isn, _ack_seqno);
+
     // Impossible ackno
-    if (unwrap(ackno, _isn, _ack_seqno) > _ack_seqno + bytes_in_flight())
+    if (abs_ackno > _ack_seqno + bytes_in_flight())
         return;
 
     // update status
+    const uint64_t previous_window_size = _window_size;
     _window_size = window_size;
+    optional<Transmission> latest_delivered{};
     // if no new segment acknowledged
-    if (_ack_seqno >= unwrap(ackno, _isn, _ack_seqno)) {
+    if (_ack_seqno >= abs_ackno) {
+        update_scoreboard(sack_blocks, latest_delivered);
+        sample_delivery_rate(latest_delivered, rtt_sample(latest_delivered, echoed_timestamp));
+        // an ACK that changes nothing while data is outstanding is a duplicate (RFC 5681)
+        if (pure_ack and abs_ackno == _ack_seqno and window_size == previous_window_size and bytes_in_flight() > 0) {
+            duplicate_ack_received();
+        }
+        if (_rack)
+            rack_detect_loss();
         return;
     }
-    _ack_seqno = unwrap(ackno, _isn, _ack_seqno);
+    // the SYN occupies a sequence number but carries no data
+    const uint64_t newly_acked = abs_ackno - _ack_seqno - (_ack_seqno == 0 ? 1 : 0);
+    // the window only grows while it limits the sender (RFC 7661)
+    const bool window_limited = _congestion and bytes_in_flight() + TCPConfig::MAX_PAYLOAD_SIZE > _congestion->window();
+    _ack_seqno = abs_ackno;
+    _duplicate_acks = 0;
 
-    // reset rto and timer
-    _rto = _initial_retransmission_timeout;
+    // reset timer
     _timer.start_time = _time;
     _retransmission_count = 0;
 
-    // clear fully acknowledged outstanding segments
-    while (1) {
-        if (_segments_outstanding.empty())
-            break;
-        auto segment = _segments_outstanding.front();
-        auto seg_seqno = unwrap(segment.header().seqno, _isn, _ack_seqno);
-        if (seg_seqno + segment.length_in_sequence_space() > _ack_seqno)
-            break;
+    // clear fully acknowledged outstanding segments (SACKed ones were delivered already)
+    while (not _segments_outstanding.empty() and _segments_outstanding.front().end() <= _ack_seqno) {
+        if (not _segments_outstanding.front().delivered)
+            deliver(_segments_outstanding.front(), latest_delivered);
         _segments_outstanding.pop_front();
     }
 
+    // trim a segment acknowledged in part, so that it is resent without the acknowledged bytes
+    if (not _segments_outstanding.empty()) {
+        OutstandingSegment &partial = _segments_outstanding.front();
+        const bool delivered = partial.delivered;
+        const uint64_t trimmed = _segments_outstanding.trim(_ack_seqno);
+        if (trimmed > 0 and not delivered)
+            deliver(partial.transmission, _ack_seqno, trimmed, latest_delivered);
+    }
+
     // stop timer if nothing left
     if (_segments_outstanding.empty())
         _timer.state = TimerState::Stop;
+
+    update_scoreboard(sack_blocks, latest_delivered);
+    const optional<uint64_t> rtt = rtt_sample(latest_delivered, echoed_timestamp);
+    sample_delivery_rate(latest_delivered, rtt);
+
+    // reset rto; an adaptive one keeps its backoff until an RTT is measured (Karn's algorithm)
+    if (not _adaptive_rto)
+        _rto = _initial_retransmission_timeout;
+
+    if (not _recover.has_value()) {
+        if (_congestion and window_limited)
+            _congestion->on_ack(newly_acked, _time);
+    } else if (_ack_seqno >= _recover.value() or (_congestion and _congestion->partial_ack_ends_recovery())) {
+        _recover.reset();
+        if (_congestion)
+            _congestion->on_recovery_end(bytes_in_flight());
+    } else {
+        // a partial ACK: the next hole was lost too (RFC 6582), unless the scoreboard says otherwise
+        if (_congestion)
+            _congestion->on_partial_ack(newly_acked);
+        if (not _receiver_sacks)
+            retransmit_oldest();
+    }
+
+    if (_rack) {
+        rack_detect_loss();
+        // the probe was answered
+        if (_tlp_end.has_value() and _ack_seqno >= _tlp_end.value())
+            _tlp_end.reset();
+        arm_tlp();
+    }
+}
+
+void TCPSender::duplicate_ack_received() {
+    _duplicate_acks++;
+    if (not _fast_retransmit) {
+        return;
+    }
+
+    if (_recover.has_value()) {
+        if (_congestion)
+            _congestion->on_recovery_dup_ack();
+    } else if (_duplicate_acks == DUPLICATE_ACK_THRESHOLD and not(_rack and _receiver_sacks)) {
+        // fast retransmit, and recover until everything sent so far is acknowledged
+        _recover = _next_seqno;
+        if (_congestion)
+            _congestion->on_fast_retransmit(bytes_in_flight(), _time);
+        retransmit_oldest();
+    }
+}
+
+//! \param outstanding The segment that reached the receiver
+//! \param latest The latest transmission delivered by this ACK so far
+void TCPSender::deliver(OutstandingSegment &outstanding, optional<Transmission> &latest) {
+    outstanding.delivered = true;
+    const TCPSegment &segment = outstanding.segment;
+    const uint64_t bytes = segment.length_in_sequence_space() - (segment.header().syn ? 1 : 0);
+    deliver(outstanding.transmission, outstanding.end(), bytes, latest);
+}
+
+//! \param transmission The transmission that reached the receiver
+//! \param end_seq The absolute seqno just past what it delivered
+//! \param bytes The data bytes it delivered
+//! \param latest The latest transmission delivered by this ACK so far
+void TCPSender::deliver(const Transmission &transmission,
+                        const uint64_t end_seq,
+                        const uint64_t bytes,
+                        optional<Transmission> &latest) {
+    _delivered += bytes;
+    _delivered_time = _time;
+    if (not latest.has_value() or transmission.sent_time >= latest->sent_time) {
+        latest = transmission;
+    }
+    if (_rack) {
+        rack_update(transmission, end_seq);
+    }
+}
+
+//! \param transmission The transmission that reached the receiver
+//! \param end_seq The absolute seqno just past what it delivered
+//! \details An ACK that arrives sooner than the minimum RTT after a retransmission is taken to
+//! be for the original transmission, and ignored.
+void TCPSender::rack_update(const Transmission &transmission, const uint64_t end_seq) {
+    const uint64_t rtt = _time - transmission.sent_time;
+    if (transmission.count == 1) {
+        _rack_min_rtt = min(rtt, _rack_min_rtt.value_or(rtt));
+    } else if (_rack_min_rtt.has_value() and rtt < _rack_min_rtt.value()) {
+        return;
+    }
+
+    const uint64_t sent_time = transmission.sent_time;
+    if (sent_time > _rack_xmit_ts or (sent_time == _rack_xmit_ts and end_seq > _rack_end_seq)) {
+        _rack_xmit_ts = sent_time;
+        _rack_end_seq = end_seq;
+        _rack_rtt = rtt;
+    }
+}
+
+//! \details The reordering window is a quarter of the minimum RTT, but no more than SRTT. A
+//! segment still within it arms a timer to look again once it has passed. The first loss found
+//! starts a recovery episode, as a fast retransmit would.
+void TCPSender::rack_detect_loss() {
+    _rack_deadline.reset();
+    if (_rack_end_seq == 0) {
+        return;
+    }
+
+    uint64_t reordering_window = _rack_min_rtt.value_or(0) / 4;
+    if (_srtt.has_value()) {
+        reordering_window = min(reordering_window, static_cast<uint64_t>(_srtt.value()));
+    }
+
+    bool lost = false;
+    for (auto &outstanding : _segments_outstanding) {
+        const uint64_t sent_time = outstanding.transmission.sent_time;
+        const bool sent_before =
+            sent_time < _rack_xmit_ts or (sent_time == _rack_xmit_ts and outstanding.end() <= _rack_end_seq);
+        if (outstanding.sacked or not sent_before) {
+            continue;
+        }
+
+        const uint64_t deadline = sent_time + _rack_rtt + reordering_window;
+        if (deadline <= _time) {
+            lost = true;
+            outstanding.retransmitted = true;
+            retransmit(outstanding);
+        } else if (not _rack_deadline.has_value() or deadline > _rack_deadline.value()) {
+            _rack_deadline = deadline;
+        }
+    }
+
+    if (lost and not _recover.has_value()) {
+        _recover = _next_seqno;
+        _tlp_deadline.reset();
+        if (_congestion)
+            _congestion->on_fast_retransmit(bytes_in_flight(), _time);
+    }
+}
+
+//! \details The probe timeout (PTO) is two SRTTs, plus TLP_MAX_ACK_DELAY if only one segment is
+//! in flight. No probe is armed in recovery, while an earlier probe is unanswered, before an RTT
+//! has been measured, or if the retransmission timer would expire first.
+void TCPSender::arm_tlp() {
+    _tlp_deadline.reset();
+    if (not _rack or _segments_outstanding.empty() or _recover.has_value() or _tlp_end.has_value() or
+        not _srtt.has_value()) {
+        return;
+    }
+
+    uint64_t pto = static_cast<uint64_t>(ceil(2 * _srtt.value()));
+    if (_segments_outstanding.size() == 1) {
+        pto += TLP_MAX_ACK_DELAY;
+    }
+    if (_time + pto < _timer.start_time + _rto) {
+        _tlp_deadline = _time + pto;
+    }
+}
+
+//! \details The retransmission timer restarts from the probe.
+void TCPSender::send_tlp() {
+    _tlp_deadline.reset();
+    const uint64_t next_seqno = _next_seqno;
+    fill_window();
+    if (_next_seqno == next_seqno) {
+        retransmit(_segments_outstanding.back());
+    }
+    _tlp_end = _next_seqno;
+    _tlp_deadline.reset();
+    _timer.start_time = _time;
+}
+
+//! \param latest The latest transmission delivered by an ACK, if any
+//! \param rtt Its round-trip time, if measured
+//! \details The interval is the longer of the time over which the data delivered since that
+//! transmission was sent and the time over which it was acknowledged, so that neither bursts
+//! of sending nor compressed ACKs overstate the rate.
+void TCPSender::sample_delivery_rate(const optional<Transmission> &latest, const optional<uint64_t> rtt) {
+    if (not latest.has_value()) {
+        return;
+    }
+    _first_sent_time = latest->sent_time;
+    if (not _congestion) {
+        return;
+    }
+
+    const uint64_t send_elapsed = latest->sent_time - latest->first_sent_time;
+    const uint64_t ack_elapsed = _delivered_time - latest->delivered_time;
+    _congestion->on_rate_sample({_delivered - latest->delivered,
+                                 max(send_elapsed, ack_elapsed),
+                                 rtt,
+                                 latest->delivered,
+                                 _delivered,
+                                 bytes_in_flight()},
+                                _time);
+}
+
+//! \param latest The latest transmission delivered by an ACK, if any
+//! \param echoed_timestamp The TSecr of the ACK, if any
+//! \returns the time since the echoed timestamp if there is one; otherwise the round-trip time of
+//! that transmission, unless the segment was retransmitted, in which case the ACK may be for
+//! either transmission (Karn's algorithm)
+optional<uint64_t> TCPSender::rtt_sample(const optional<Transmission> &latest,
+                                         const optional<uint32_t> echoed_timestamp) {
+    if (not latest.has_value()) {
+        return nullopt;
+    }
+
+    uint64_t rtt = 0;
+    if (echoed_timestamp.has_value()) {
+        rtt = static_cast<uint32_t>(timestamp() - echoed_timestamp.value());
+    } else if (latest->count == 1) {
+        rtt = _time - latest->sent_time;
+    } else {
+        return nullopt;
+    }
+    const double r = static_cast<double>(rtt);
+    _latest_rtt = rtt;
+    if (not _srtt.has_value()) {
+        _srtt = r;
+        _rttvar = r / 2;
+    } else {
+        _rttvar = 0.75 * _rttvar + 0.25 * abs(_srtt.value() - r);
+        _srtt = 0.875 * _srtt.value() + 0.125 * r;
+    }
+
+    if (_adaptive_rto) {
+        // the clock granularity G is one millisecond
+        const double rto = ceil(_srtt.value() + max(1.0, 4 * _rttvar));
+        _rto = clamp(static_cast<uint32_t>(rto), _rto_min, _rto_max);
+    }
+    return rtt;
+}
+
+//! \param sack_blocks The SACK blocks the remote receiver reported
+//! \param latest The latest transmission delivered by this ACK so far
+//! \details Blocks that do not lie between the ackno and the next seqno are ignored.
+void TCPSender::update_scoreboard(const vector<TCPHeader::SACKBlock> &sack_blocks, optional<Transmission> &latest) {
+    if (sack_blocks.empty()) {
+        return;
+    }
+    _receiver_sacks = true;
+
+    for (const auto &block : sack_blocks) {
+        const uint64_t left = unwrap(block.left, _isn, _ack_seqno);
+        const uint64_t right = unwrap(block.right, _isn, _ack_seqno);
+        if (left < _ack_seqno or right <= left or right > _next_seqno) {
+            continue;
+        }
+        for (auto it = _segments_outstanding.find(left); it != _segments_outstanding.end() and it->seqno < right;
+             ++it) {
+            if (it->seqno >= left and it->end() <= right and not it->sacked) {
+                it->sacked = true;
+                // SACKed again after a timeout cleared the scoreboard: its bytes were counted already
+                if (not it->delivered)
+                    deliver(*it, latest);
+            }
+        }
+    }
+
+    // RACK finds the holes by time instead
+    if (_rack) {
+        return;
+    }
+
+    // resend, lowest first, each hole with enough SACKed segments above it
+    size_t sacked_above = count_if(_segments_outstanding.begin(),
+                                   _segments_outstanding.end(),
+                                   [](const OutstandingSegment &outstanding) { return outstanding.sacked; });
+    for (auto &outstanding : _segments_outstanding) {
+        if (outstanding.sacked) {
+            sacked_above--;
+        } else if (sacked_above >= SACK_LOSS_THRESHOLD and not outstanding.retransmitted) {
+            outstanding.retransmitted = true;
+            retransmit(outstanding);
+        }
+    }
 }
 
 //! \param[in] ms_since_last_tick the number of milliseconds since the last call to this method
 void TCPSender::tick(const size_t ms_since_last_tick) {
     _time += ms_since_last_tick;
 
+    // earn pacing credit, and release whatever it allows
+    const optional<double> rate = pacing_rate();
+    if (rate.has_value()) {
+        const double earned = rate.value() * static_cast<double>(ms_since_last_tick);
+        _pacing_credit = min(_pacing_credit + earned, max(earned, PACING_BURST));
+        if (_next_seqno > 0)
+            fill_window();
+    }
+
     if (_segments_outstanding.empty())
         return;
 
+    // RACK's reordering window ran out, or a loss probe is due
+    if (_rack_deadline.has_value() and _rack_deadline.value() <= _time)
+        rack_detect_loss();
+    if (_tlp_deadline.has_value() and _tlp_deadline.value() <= _time)
+        send_tlp();
+
     // expired
     if (_timer.state == TimerState::Running && _timer.start_time + _rto <= _time) {
         // resend earliest segment
-        _segments_out.push(_segments_outstanding.front());
+        retransmit(_segments_outstanding.front());
+
+        // the receiver may have discarded data it SACKed (RFC 2018), so start the scoreboard afresh
+        for (auto &outstanding : _segments_outstanding) {
+            outstanding.sacked = false;
+            outstanding.retransmitted = false;
+        }
 
         // double the rto and increment count, if window is nonzero
         if (_window_size != 0) {
-            _rto *= 2;
+            _rto = _adaptive_rto ? min<uint64_t>(uint64_t{_rto} * 2, _rto_max) : _rto * 2;
             _retransmission_count += 1;
+            if (_congestion) {
+                _congestion->on_timeout(bytes_in_flight(), _time);
+            }
         }
+        _recover.reset();
+        _duplicate_acks = 0;
+        _rack_deadline.reset();
+        _tlp_deadline.reset();
+        _tlp_end.reset();
 
         // restart timer
         _timer.start_time = _time;
@@ -116,9 +517,44 @@ void TCPSender::tick(const size_t ms_since_last_tick) {
 
 unsigned int TCPSender::consecutive_retransmissions() const { return _retransmission_count; }
 
+optional<uint64_t> TCPSender::congestion_window() const {
+    if (not _congestion) {
+        return nullopt;
+    }
+    return _congestion->window();
+}
+
+optional<double> TCPSender::rtt_variation() const {
+    if (not _srtt.has_value()) {
+        return nullopt;
+    }
+    return _rttvar;
+}
+
+optional<double> TCPSender::pacing_rate() const {
+    if (not _congestion) {
+        return nullopt;
+    }
+    return _congestion->pacing_rate();
+}
+
+void TCPSender::retransmit(OutstandingSegment &outstanding) {
+    const unsigned int count = outstanding.transmission.count + 1;
+    outstanding.transmission = {_time, _first_sent_time, _delivered, _delivered_time, count};
+    _segments_out.push(outstanding.segment);
+}
+
+void TCPSender::retransmit_oldest() {
+    if (_segments_outstanding.empty() or _segments_outstanding.front().retransmitted) {
+        return;
+    }
+    _segments_outstanding.front().retransmitted = true;
+    retransmit(_segments_outstanding.front());
+}
+
 void TCPSender::send_empty_segment() {
     TCPSegment new_segment{};
     new_segment.header().seqno = WrappingInt32{wrap(_next_seqno, _isn)};
 
-    _segments_out.push(new_segment);
+    _segments_out.push(move(new_segment));
 }
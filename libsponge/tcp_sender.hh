@@ -2,6 +2,8 @@
 #define SPONGE_LIBSPONGE_TCP_SENDER_HH
 
 #include "byte_stream.hh"
+#include "congestion_controller.hh"
+#include "retransmission_queue.hh"
 #include "tcp_config.hh"
 #include "tcp_segment.hh"
 #include "wrapping_integers.hh"
@@ -9,7 +11,11 @@
 #include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <limits>
+#include <memory>
+#include <optional>
 #include <queue>
+#include <vector>
 
 //! \brief The "sender" part of a TCP implementation.
 
@@ -17,6 +23,46 @@
 //! segments, keeps track of which segments are still in-flight,
 //! maintains the Retransmission Timer, and retransmits in-flight
 //! segments if the retransmission timer expires.
+//!
+//! If the receiver reports SACK blocks ([RFC 2018](\ref rfc::rfc2018)), the sender keeps a
+//! scoreboard of which outstanding segments the receiver holds. A segment with at least
+//! SACK_LOSS_THRESHOLD SACKed segments above it is considered lost and resent once, without
+//! waiting for the timer; SACKed segments are never resent.
+//!
+//! With TCPConfig::fast_retransmit, the sender counts duplicate ACKs, fast-retransmits the
+//! oldest outstanding segment on the third, and stays in fast recovery until the data
+//! outstanding at that point has been acknowledged, resending the next hole on each partial ACK
+//! unless the receiver SACKs ([RFC 5681](\ref rfc::rfc5681), [RFC 6582](\ref rfc::rfc6582)).
+//!
+//! With a CongestionController (TCPConfig::congestion_control), the bytes in flight are also
+//! limited by its congestion window, which follows those loss events (fast retransmit is then
+//! always on). Each ACK that newly acknowledges or SACKs data gives the controller a delivery
+//! rate sample; if it returns a pacing rate, fill_window only releases new segments as
+//! tick() earns credit for them.
+//!
+//! Unless TCPConfig::nodelay is set, fill_window follows Nagle's algorithm: while data is in
+//! flight, it holds back a segment smaller than the MSS until that data is acknowledged or
+//! enough has been written to fill one, except for the last data before a FIN.
+//!
+//! With TCPConfig::segmentation_offload, an unpaced sender builds segments of up to
+//! TCPConfig::MAX_OFFLOAD_SIZE bytes, and the FD adapter splits them (TCPSegment::split). The
+//! sender splits them the same way to track them, so a loss resends a single MSS piece.
+//!
+//! Outstanding segments are kept in a RetransmissionQueue by absolute seqno. An ACK that covers
+//! only part of one trims it, so that it is resent without the acknowledged bytes.
+//!
+//! With TCPConfig::rack, once the receiver SACKs, losses are detected by time instead
+//! ([RFC 8985](\ref rfc::rfc8985)): a segment is lost once a segment sent after it has been
+//! delivered and a reordering window of a quarter of the minimum RTT has passed on top of that
+//! segment's RTT. While data is outstanding outside of recovery, a tail loss probe goes out two
+//! SRTTs after the last new ACK, so that a loss at the end of a flight brings SACKs back instead
+//! of waiting for the retransmission timer.
+//!
+//! The same ACKs give round-trip time measurements, except for retransmitted segments (Karn's
+//! algorithm). If the ACK echoes a timestamp ([RFC 7323](\ref rfc::rfc7323)), the measurement
+//! is taken from it instead, so retransmitted segments are measured too. The sender keeps SRTT
+//! and RTTVAR as in [RFC 6298](\ref rfc::rfc6298), and with TCPConfig::adaptive_rto derives the
+//! retransmission timeout from them.
 class TCPSender {
   private:
     enum TimerState { Stop, Running };
@@ -32,14 +78,121 @@ class TCPSender {
     //! outbound queue of segments that the TCPSender wants sent
     std::queue<TCPSegment> _segments_out{};
 
+    using Transmission = RetransmissionQueue::Transmission;
+    using OutstandingSegment = RetransmissionQueue::Entry;
+
     //! outstanding segments
-    std::deque<TCPSegment> _segments_outstanding{};
+    RetransmissionQueue _segments_outstanding{};
+
+    //! has the receiver reported SACK blocks? If so, holes are resent from the scoreboard alone
+    bool _receiver_sacks{false};
+
+    //! mark outstanding segments covered by `sack_blocks`, then resend those now considered lost
+    void update_scoreboard(const std::vector<TCPHeader::SACKBlock> &sack_blocks, std::optional<Transmission> &latest);
+
+    //! congestion controller, if one is configured
+    std::unique_ptr<CongestionController> _congestion{};
+
+    //! fast retransmit and recovery (TCPConfig::fast_retransmit, or any congestion controller)
+    bool _fast_retransmit{false};
+
+    //! number of duplicate ACKs received in a row
+    unsigned int _duplicate_acks{0};
+
+    //! while in fast recovery, the absolute seqno that ends it once acknowledged
+    std::optional<uint64_t> _recover{};
+
+    //! count a duplicate ACK, and fast-retransmit or inflate the window as needed
+    void duplicate_ack_received();
+
+    //! RACK-TLP loss detection (TCPConfig::rack)
+    bool _rack{false};
+
+    //! the most recently sent segment known to be delivered: when it was sent, where it ends, and its RTT
+    uint64_t _rack_xmit_ts{0};
+    uint64_t _rack_end_seq{0};
+    uint64_t _rack_rtt{0};
+
+    //! the smallest RTT measured on a segment that was sent once, in ms
+    std::optional<uint64_t> _rack_min_rtt{};
+
+    //! when the reordering window of an outstanding segment runs out, if RACK is waiting for one
+    std::optional<uint64_t> _rack_deadline{};
+
+    //! when to send a tail loss probe, if one is armed
+    std::optional<uint64_t> _tlp_deadline{};
+
+    //! the next seqno when the last loss probe was sent, until an ACK covers it
+    std::optional<uint64_t> _tlp_end{};
+
+    //! make a delivered transmission the most recent one RACK knows of, if it is
+    void rack_update(const Transmission &transmission, const uint64_t end_seq);
+
+    //! resend the segments sent a reordering window before the most recent one delivered
+    void rack_detect_loss();
+
+    //! arm the loss probe timer, unless no probe is due
+    void arm_tlp();
+
+    //! send new data if the windows allow it, or else resend the last segment
+    void send_tlp();
+
+    //! the most bytes that may be in flight: the receiver's window, limited by the congestion window
+    uint64_t send_window() const;
+
+    //! resend an outstanding segment
+    void retransmit(OutstandingSegment &outstanding);
+
+    //! resend the oldest outstanding segment, unless it was already resent since the last timeout
+    void retransmit_oldest();
+
+    //! bytes acknowledged or SACKed so far (not counting the SYN), and when that last changed
+    uint64_t _delivered{0};
+    uint64_t _delivered_time{0};
+
+    //! when the latest segment delivered so far was sent
+    uint64_t _first_sent_time{0};
+
+    //! count a segment as delivered, keeping in `latest` the latest transmission delivered by this ACK
+    void deliver(OutstandingSegment &outstanding, std::optional<Transmission> &latest);
+
+    //! count `bytes` sent by `transmission`, ending at `end_seq`, as delivered, likewise
+    void deliver(const Transmission &transmission,
+                 const uint64_t end_seq,
+                 const uint64_t bytes,
+                 std::optional<Transmission> &latest);
+
+    //! give the congestion controller a delivery rate sample for the latest transmission delivered
+    void sample_delivery_rate(const std::optional<Transmission> &latest, const std::optional<uint64_t> rtt);
+
+    //! bytes that may still be released before the pacing rate is exceeded
+    double _pacing_credit{0};
 
     //! retransmission timer for the connection
     unsigned int _initial_retransmission_timeout;
     uint32_t _rto;
     uint32_t _retransmission_count{0};
 
+    //! adaptive retransmission timeout (TCPConfig::adaptive_rto) and its bounds
+    bool _adaptive_rto{false};
+    uint32_t _rto_min{0};
+    uint32_t _rto_max{std::numeric_limits<uint32_t>::max()};
+
+    //! round-trip time estimates, in ms
+    std::optional<uint64_t> _latest_rtt{};
+    std::optional<double> _srtt{};
+    double _rttvar{0};
+
+    //! measure the RTT of the latest transmission delivered, update the estimates and an adaptive RTO
+    std::optional<uint64_t> rtt_sample(const std::optional<Transmission> &latest,
+                                       const std::optional<uint32_t> echoed_timestamp);
+
+    //! send small segments at once, rather than holding them back while data is in flight (Nagle)
+    bool _nodelay{true};
+
+    //! largest payload of a new segment: MAX_PAYLOAD_SIZE, or MAX_OFFLOAD_SIZE with segmentation offload
+    size_t _max_payload_size{TCPConfig::MAX_PAYLOAD_SIZE};
+
     //! outgoing stream of bytes that have not yet been sent
     ByteStream _stream;
 
@@ -55,11 +208,26 @@ class TCPSender {
     uint64_t _time{0};
 
   public:
+    //! SACKed segments above an un-SACKed one that mark it as lost (RFC 6675's DupThresh)
+    static constexpr size_t SACK_LOSS_THRESHOLD = 3;
+
+    //! Duplicate ACKs that trigger a fast retransmit
+    static constexpr unsigned int DUPLICATE_ACK_THRESHOLD = 3;
+
+    //! Bytes a paced sender may release at once, beyond what it earned in the last tick
+    static constexpr double PACING_BURST = 2 * TCPConfig::MAX_PAYLOAD_SIZE;
+
+    //! Time a loss probe allows for a delayed ACK when a single segment is in flight, in ms (WCDelAckT)
+    static constexpr uint64_t TLP_MAX_ACK_DELAY = 200;
+
     //! Initialize a TCPSender
     TCPSender(const size_t capacity = TCPConfig::DEFAULT_CAPACITY,
               const uint16_t retx_timeout = TCPConfig::TIMEOUT_DFLT,
               const std::optional<WrappingInt32> fixed_isn = {});
 
+    //! Initialize a TCPSender from the sender-side fields of a TCPConfig
+    explicit TCPSender(const TCPConfig &cfg);
+
     //! \name "Input" interface for the writer
     //!@{
     ByteStream &stream_in() { return _stream; }
@@ -69,8 +237,15 @@ class TCPSender {
     //! \name Methods that can cause the TCPSender to send a segment
     //!@{
 
-    //! \brief A new acknowledgment was received
-    void ack_received(const WrappingInt32 ackno, const uint16_t window_size);
+    //! \brief A new acknowledgment was received, possibly with SACK blocks
+    //! \note `window_size` is in bytes, after any window scaling has been applied
+    //! \note only a `pure_ack` (one in a segment without data, SYN or FIN) can be a duplicate ACK
+    //! \note `echoed_timestamp` is the TSecr of the segment, if timestamps are in use
+    void ack_received(const WrappingInt32 ackno,
+                      const uint64_t window_size,
+                      const std::vector<TCPHeader::SACKBlock> &sack_blocks = {},
+                      const bool pure_ack = true,
+                      const std::optional<uint32_t> echoed_timestamp = {});
 
     //! \brief Generate an empty-payload segment (useful for creating empty ACK segments)
     void send_empty_segment();
@@ -93,6 +268,34 @@ class TCPSender {
     //! \brief Number of consecutive retransmissions that have occurred in a row
     unsigned int consecutive_retransmissions() const;
 
+    //! \brief The congestion window, in bytes, if a congestion controller is configured
+    std::optional<uint64_t> congestion_window() const;
+
+    //! \brief Is the sender in fast recovery?
+    bool in_fast_recovery() const { return _recover.has_value(); }
+
+    //! \brief The rate at which new segments are released, in bytes per ms, if the sender is paced
+    std::optional<double> pacing_rate() const;
+
+    //! \brief The most recent round-trip time measurement, in ms
+    std::optional<uint64_t> latest_rtt() const { return _latest_rtt; }
+
+    //! \brief The smoothed round-trip time (SRTT), in ms, once an RTT has been measured
+    std::optional<double> smoothed_rtt() const { return _srtt; }
+
+    //! \brief The round-trip time variation (RTTVAR), in ms, once an RTT has been measured
+    std::optional<double> rtt_variation() const;
+
+    //! \brief The current retransmission timeout, in ms
+    unsigned int retransmission_timeout() const { return _rto; }
+
+    //! \brief The data bytes the receiver has reported holding, by ACKs and SACKs, from which the
+    //! delivery rate samples are taken
+    uint64_t bytes_delivered() const { return _delivered; }
+
+    //! \brief The TSval for a segment sent now: the sender's clock in ms, modulo 2^32
+    uint32_t timestamp() const { return static_cast<uint32_t>(_time); }
+
     //! \brief TCPSegments that the TCPSender has enqueued for transmission.
     //! \note These must be dequeued and sent by the TCPConnection,
     //! which will need to fill in the fields that are set by the TCPReceiver
@@ -100,6 +100,22 @@ pair<string, uint16_t> Address::ip_port() const {
     return {ip.data(), stoi(port.data())};
 }
 
+//! \details Read straight from the socket address for IPv4 and IPv6, since the adapters ask for it
+//! for every segment they wrap or unwrap
+uint16_t Address::port() const {
+    if (_address.storage.ss_family == AF_INET and _size == sizeof(sockaddr_in)) {
+        sockaddr_in ipv4_addr{};
+        memcpy(&ipv4_addr, &_address.storage, _size);
+        return be16toh(ipv4_addr.sin_port);
+    }
+    if (_address.storage.ss_family == AF_INET6 and _size == sizeof(sockaddr_in6)) {
+        sockaddr_in6 ipv6_addr{};
+        memcpy(&ipv6_addr, &_address.storage, _size);
+        return be16toh(ipv6_addr.sin6_port);
+    }
+    return ip_port().second;
+}
+
 string Address::to_string() const {
     const auto ip_and_port = ip_port();
     return ip_and_port.first + ":" + ::to_string(ip_and_port.second);
@@ -7,7 +7,18 @@ void Buffer::remove_prefix(const size_t n) {
         throw out_of_range("Buffer::remove_prefix");
     }
     _starting_offset += n;
-    if (_storage and _starting_offset == _storage->size()) {
+    _length -= n;
+    if (_storage and _length == 0) {
+        _storage.reset();
+    }
+}
+
+void Buffer::remove_suffix(const size_t n) {
+    if (n > str().size()) {
+        throw out_of_range("Buffer::remove_suffix");
+    }
+    _length -= n;
+    if (_storage and _length == 0) {
         _storage.reset();
     }
 }
@@ -18,6 +29,8 @@ void BufferList::append(const BufferList &other) {
     }
 }
 
+void BufferList::append(Buffer buffer) { _buffers.push_back(std::move(buffer)); }
+
 BufferList::operator Buffer() const {
     switch (_buffers.size()) {
         case 0:
@@ -49,19 +62,21 @@ size_t BufferList::size() const {
 }
 
 void BufferList::remove_prefix(size_t n) {
+    auto first = _buffers.begin();
     while (n > 0) {
-        if (_buffers.empty()) {
+        if (first == _buffers.end()) {
             throw std::out_of_range("BufferList::remove_prefix");
         }
 
-        if (n < _buffers.front().str().size()) {
-            _buffers.front().remove_prefix(n);
+        if (n < first->str().size()) {
+            first->remove_prefix(n);
             n = 0;
         } else {
-            n -= _buffers.front().str().size();
-            _buffers.pop_front();
+            n -= first->str().size();
+            ++first;
         }
     }
+    _buffers.erase(_buffers.begin(), first);
 }
 
 BufferViewList::BufferViewList(const BufferList &buffers) {
@@ -70,6 +85,12 @@ BufferViewList::BufferViewList(const BufferList &buffers) {
     }
 }
 
+void BufferViewList::append(string_view str) {
+    if (not str.empty()) {
+        _views.push_back(str);
+    }
+}
+
 void BufferViewList::remove_prefix(size_t n) {
     while (n > 0) {
         if (_views.empty()) {
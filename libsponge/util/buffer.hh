@@ -2,6 +2,7 @@
 #define SPONGE_LIBSPONGE_BUFFER_HH
 
 #include <algorithm>
+#include <array>
 #include <deque>
 #include <memory>
 #include <numeric>
@@ -16,12 +17,14 @@ class Buffer {
   private:
     std::shared_ptr<std::string> _storage{};
     size_t _starting_offset{};
+    size_t _length{};
 
   public:
     Buffer() = default;
 
     //! \brief Construct by taking ownership of a string
-    Buffer(std::string &&str) noexcept : _storage(std::make_shared<std::string>(std::move(str))) {}
+    Buffer(std::string &&str) noexcept
+        : _storage(std::make_shared<std::string>(std::move(str))), _length(_storage->size()) {}
 
     //! \name Expose contents as a std::string_view
     //!@{
@@ -29,7 +32,7 @@ class Buffer {
         if (not _storage) {
             return {};
         }
-        return {_storage->data() + _starting_offset, _storage->size() - _starting_offset};
+        return {_storage->data() + _starting_offset, _length};
     }
 
     operator std::string_view() const { return str(); }
@@ -47,6 +50,10 @@ class Buffer {
     //! \brief Discard the first `n` bytes of the string (does not require a copy or move)
     //! \note Doesn't free any memory until the whole string has been discarded in all copies of the Buffer.
     void remove_prefix(const size_t n);
+
+    //! \brief Discard the last `n` bytes of the string (does not require a copy or move)
+    //! \note Other copies of the Buffer still see the discarded bytes.
+    void remove_suffix(const size_t n);
 };
 
 //! \brief A reference-counted discontiguous string that can discard bytes from the front
@@ -54,9 +61,11 @@ class Buffer {
 //! + a payload. This allows us to prepend headers (e.g., to
 //! encapsulate a TCP payload in a TCPSegment, and then encapsulate
 //! the TCPSegment in an IPv4Datagram) without copying the payload.
+//! The Buffers are kept in a vector, so an empty BufferList allocates
+//! nothing and a one-Buffer BufferList allocates only once.
 class BufferList {
   private:
-    std::deque<Buffer> _buffers{};
+    std::vector<Buffer> _buffers{};
 
   public:
     //! \name Constructors
@@ -65,21 +74,24 @@ class BufferList {
     BufferList() = default;
 
     //! \brief Construct from a Buffer
-    BufferList(Buffer buffer) : _buffers{buffer} {}
+    BufferList(Buffer buffer) { append(std::move(buffer)); }
 
     //! \brief Construct by taking ownership of a std::string
-    BufferList(std::string &&str) noexcept {
-        Buffer buf{std::move(str)};
-        append(buf);
-    }
+    BufferList(std::string &&str) noexcept { append(std::move(str)); }
     //!@}
 
-    //! \brief Access the underlying queue of Buffers
-    const std::deque<Buffer> &buffers() const { return _buffers; }
+    //! \brief Access the underlying sequence of Buffers
+    const std::vector<Buffer> &buffers() const { return _buffers; }
 
     //! \brief Append a BufferList
     void append(const BufferList &other);
 
+    //! \brief Append a Buffer
+    void append(Buffer buffer);
+
+    //! \brief Append by taking ownership of a std::string
+    void append(std::string &&str) { append(Buffer{std::move(str)}); }
+
     //! \brief Transform to a Buffer
     //! \note Throws an exception unless BufferList is contiguous
     operator Buffer() const;
@@ -102,6 +114,8 @@ class BufferViewList {
     //! \name Constructors
     //!@{
 
+    BufferViewList() = default;
+
     //! \brief Construct from a std::string
     BufferViewList(const std::string &str) : BufferViewList(std::string_view(str)) {}
 
@@ -115,6 +129,9 @@ class BufferViewList {
     BufferViewList(std::string_view str) { _views.push_back({const_cast<char *>(str.data()), str.size()}); }
     //!@}
 
+    //! \brief Append a view (empty views are skipped)
+    void append(std::string_view str);
+
     //! \brief Discard the first `n` bytes of the string (does not require a copy or move)
     void remove_prefix(size_t n);
 
@@ -127,4 +144,33 @@ class BufferViewList {
     std::vector<iovec> as_iovecs() const;
 };
 
+//! \brief A fixed-size buffer that fills from the back, so that a packet's headers can be
+//! prepended in place, innermost first, without allocating
+template <size_t N>
+class HeadroomBuffer {
+  private:
+    std::array<char, N> _storage{};
+    size_t _start = N;  //!< index of the first byte in use
+
+  public:
+    //! \brief Reserve `n` bytes in front of what is already there
+    //! \returns where the caller writes them
+    char *prepend(const size_t n) {
+        if (n > _start) {
+            throw std::runtime_error("HeadroomBuffer: not enough headroom");
+        }
+        _start -= n;
+        return _storage.data() + _start;
+    }
+
+    //! \brief The bytes prepended so far
+    std::string_view str() const { return {_storage.data() + _start, N - _start}; }
+
+    //! \brief Number of bytes prepended so far
+    size_t size() const { return N - _start; }
+
+    //! \brief Discard the contents, restoring all of the headroom
+    void clear() { _start = N; }
+};
+
 #endif  // SPONGE_LIBSPONGE_BUFFER_HH
@@ -17,37 +17,25 @@ string as_string(const ParseResult r) {
     return _names[static_cast<size_t>(r)];
 }
 
-void NetParser::_check_size(const size_t size) {
-    if (size > _buffer.size()) {
-        set_error(ParseResult::PacketTooShort);
-    }
+Buffer NetParser::buffer() const {
+    Buffer ret = _buffer;
+    ret.remove_prefix(_buffer.size() - _view.size());
+    return ret;
 }
 
-template <typename T>
-T NetParser::_parse_int() {
-    constexpr size_t len = sizeof(T);
-    _check_size(len);
-    if (error()) {
-        return 0;
-    }
-
-    T ret = 0;
-    for (size_t i = 0; i < len; i++) {
-        ret = ret << 8;
-        ret += uint8_t(_buffer.at(i));
+void NetParser::remove_prefix(const size_t n) {
+    if (_check_size(n)) {
+        _view.remove_prefix(n);
     }
-
-    _buffer.remove_prefix(len);
-
-    return ret;
 }
 
-void NetParser::remove_prefix(const size_t n) {
-    _check_size(n);
-    if (error()) {
-        return;
+string_view NetParser::take(const size_t n) {
+    if (not _check_size(n)) {
+        return {};
     }
-    _buffer.remove_prefix(n);
+    const string_view ret = _view.substr(0, n);
+    _view.remove_prefix(n);
+    return ret;
 }
 
 template <typename T>
@@ -59,12 +47,6 @@ void NetUnparser::_unparse_int(string &s, T val) {
     }
 }
 
-uint32_t NetParser::u32() { return _parse_int<uint32_t>(); }
-
-uint16_t NetParser::u16() { return _parse_int<uint16_t>(); }
-
-uint8_t NetParser::u8() { return _parse_int<uint8_t>(); }
-
 void NetUnparser::u32(string &s, const uint32_t val) { return _unparse_int<uint32_t>(s, val); }
 
 void NetUnparser::u16(string &s, const uint16_t val) { return _unparse_int<uint16_t>(s, val); }
@@ -3,9 +3,12 @@
 
 #include "buffer.hh"
 
+#include <arpa/inet.h>
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <string>
+#include <string_view>
 #include <utility>
 
 //! The result of parsing or unparsing an IP datagram, TCP segment, Ethernet frame, or ARP message
@@ -22,22 +25,37 @@ enum class ParseResult {
 //! Output a string representation of a ParseResult
 std::string as_string(const ParseResult r);
 
+//! \brief A cursor over a Buffer that reads integers in network byte order
+//! \details The cursor is a view of the bytes not yet parsed, so reading a field only moves the view;
+//! the Buffer is touched again only by buffer(). A fixed-size header can be checked once with take()
+//! and its fields read at their offsets with the unchecked load_u8(), load_u16() and load_u32().
 class NetParser {
   private:
     Buffer _buffer;
+    std::string_view _view;                     //!< The bytes of `_buffer` not yet parsed
     ParseResult _error = ParseResult::NoError;  //!< Result of parsing so far
 
     //! Check that there is sufficient data to parse the next token
-    void _check_size(const size_t size);
+    //! \returns `false` if there is not, or if there has already been an error
+    bool _check_size(const size_t size) {
+        if (size > _view.size()) {
+            set_error(ParseResult::PacketTooShort);
+        }
+        return not error();
+    }
 
     //! Generic integer parsing method (used by u32, u16, u8)
     template <typename T>
     T _parse_int();
 
   public:
-    NetParser(Buffer buffer) : _buffer(buffer) {}
+    NetParser(Buffer buffer) : _buffer(std::move(buffer)), _view(_buffer.str()) {}
 
-    Buffer buffer() const { return _buffer; }
+    //! The bytes not yet parsed
+    Buffer buffer() const;
+
+    //! The number of bytes not yet parsed
+    size_t size() const { return _view.size(); }
 
     //! Get the current value stored in BaseParser::_error
     ParseResult get_error() const { return _error; }
@@ -50,22 +68,72 @@ class NetParser {
     bool error() const { return get_error() != ParseResult::NoError; }
 
     //! Parse a 32-bit integer in network byte order from the data stream
-    uint32_t u32();
+    uint32_t u32() { return _parse_int<uint32_t>(); }
 
     //! Parse a 16-bit integer in network byte order from the data stream
-    uint16_t u16();
+    uint16_t u16() { return _parse_int<uint16_t>(); }
 
     //! Parse an 8-bit integer in network byte order from the data stream
-    uint8_t u8();
+    uint8_t u8() { return _parse_int<uint8_t>(); }
 
     //! Remove n bytes from the buffer
     void remove_prefix(const size_t n);
+
+    //! \brief Take the next `n` bytes with one size check, e.g. the fixed part of a header
+    //! \returns a view of them, or an empty view (and a PacketTooShort error) if there are fewer
+    std::string_view take(const size_t n);
+
+    //! \name Read an integer in network byte order at `data`, which the caller has checked is long enough
+    //!@{
+    static uint8_t load_u8(const char *data) { return static_cast<uint8_t>(*data); }
+
+    static uint16_t load_u16(const char *data) {
+        uint16_t val;
+        memcpy(&val, data, sizeof(val));
+        return ntohs(val);
+    }
+
+    static uint32_t load_u32(const char *data) {
+        uint32_t val;
+        memcpy(&val, data, sizeof(val));
+        return ntohl(val);
+    }
+    //!@}
 };
 
+template <typename T>
+T NetParser::_parse_int() {
+    if (not _check_size(sizeof(T))) {
+        return 0;
+    }
+
+    T ret;
+    if constexpr (sizeof(T) == 1) {
+        ret = load_u8(_view.data());
+    } else if constexpr (sizeof(T) == 2) {
+        ret = load_u16(_view.data());
+    } else {
+        ret = load_u32(_view.data());
+    }
+
+    _view.remove_prefix(sizeof(T));
+
+    return ret;
+}
+
 struct NetUnparser {
     template <typename T>
     static void _unparse_int(std::string &s, T val);
 
+    //! Inline, so that a header's fixed offsets become plain stores
+    template <typename T>
+    static void _unparse_int(char *out, T val) {
+        constexpr size_t len = sizeof(T);
+        for (size_t i = 0; i < len; ++i) {
+            out[i] = static_cast<char>((val >> ((len - i - 1) * 8)) & 0xff);
+        }
+    }
+
     //! Write a 32-bit integer into the data stream in network byte order
     static void u32(std::string &s, const uint32_t val);
 
@@ -74,6 +142,13 @@ struct NetUnparser {
 
     //! Write an 8-bit integer into the data stream in network byte order
     static void u8(std::string &s, const uint8_t val);
+
+    //! \name Write an integer in network byte order at `out`, which must have room for it
+    //!@{
+    static void u32(char *out, const uint32_t val) { _unparse_int<uint32_t>(out, val); }
+    static void u16(char *out, const uint16_t val) { _unparse_int<uint16_t>(out, val); }
+    static void u8(char *out, const uint8_t val) { _unparse_int<uint8_t>(out, val); }
+    //!@}
 };
 
 #endif  // SPONGE_LIBSPONGE_PARSER_HH
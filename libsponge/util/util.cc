@@ -1,13 +1,20 @@
 #include "util.hh"
 
+#include <arpa/inet.h>
 #include <array>
 #include <cctype>
 #include <chrono>
+#include <cstring>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
+#include <stdexcept>
 #include <sys/socket.h>
 
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
 using namespace std;
 
 //! \returns the number of milliseconds since the program started
@@ -84,21 +91,170 @@ mt19937 get_random_generator() {
 //!
 //! For more information, see the [Wikipedia page](https://en.wikipedia.org/wiki/IPv4_header_checksum)
 //! on the Internet checksum, and consult the [IP](\ref rfc::rfc791) and [TCP](\ref rfc::rfc793) RFCs.
-InternetChecksum::InternetChecksum(const uint32_t initial_sum) : _sum(initial_sum) {}
+//! \param[in] initial_sum is added to the sum, e.g. the checksum of a pseudo-header
+//! \param[in] kernel is the implementation of the summing loop to use
+InternetChecksum::InternetChecksum(const uint32_t initial_sum, const Kernel kernel)
+    : _sum(initial_sum), _kernel(kernel) {
+    if (not supported(kernel)) {
+        throw runtime_error("InternetChecksum: kernel not supported on this CPU");
+    }
+}
+
+// The kernels sum the data as native-endian words into a 64-bit accumulator, as if it started at
+// an even offset. Because the ones' complement sum does not depend on byte order or word size
+// (RFC 1071), folding that sum to 16 bits and swapping the bytes on a little-endian machine gives
+// the sum of the big-endian 16-bit words.
+namespace {
+
+//! Add `word` to `sum` with an end-around carry
+inline uint64_t add_with_carry(const uint64_t sum, const uint64_t word) {
+    const uint64_t ret = sum + word;
+    return ret + (ret < word ? 1 : 0);
+}
 
-void InternetChecksum::add(std::string_view data) {
-    for (size_t i = 0; i < data.size(); i++) {
-        uint16_t val = uint8_t(data[i]);
-        if (not _parity) {
-            val <<= 8;
+//! Sum whatever is left (fewer than 8 bytes), padded with zeros to a 64-bit word, copying it to `dest` if `Copy`
+template <bool Copy>
+inline uint64_t sum_tail(const uint64_t sum, const char *data, const size_t len, char *dest) {
+    uint64_t word = 0;
+    memcpy(&word, data, len);
+    if (Copy) {
+        memcpy(dest, &word, len);
+    }
+    return add_with_carry(sum, word);
+}
+
+// With `Copy`, each kernel also stores every word it loads to `dest`, so the data is read only once.
+
+template <bool Copy>
+uint64_t sum_portable(const char *data, size_t len, char *dest) {
+    uint64_t sum = 0;
+    for (; len >= 8; data += 8, dest += Copy ? 8 : 0, len -= 8) {
+        uint64_t word;
+        memcpy(&word, data, 8);
+        if (Copy) {
+            memcpy(dest, &word, 8);
         }
-        _sum += val;
-        _parity = !_parity;
+        sum = add_with_carry(sum, word);
+    }
+    return sum_tail<Copy>(sum, data, len, dest);
+}
+
+#if defined(__x86_64__)
+//! Each 32-bit word is widened into a 64-bit lane, which cannot overflow for any real input
+template <bool Copy>
+uint64_t sum_sse2(const char *data, size_t len, char *dest) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc = zero;
+    for (; len >= 16; data += 16, dest += Copy ? 16 : 0, len -= 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+        if (Copy) {
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dest), v);
+        }
+        acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(v, zero));
+        acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(v, zero));
+    }
+    alignas(16) array<uint64_t, 2> lanes{};
+    _mm_store_si128(reinterpret_cast<__m128i *>(lanes.data()), acc);
+    uint64_t sum = add_with_carry(lanes[0], lanes[1]);
+    if (len >= 8) {
+        sum = sum_tail<Copy>(sum, data, 8, dest);
+        data += 8;
+        dest += Copy ? 8 : 0;
+        len -= 8;
+    }
+    return sum_tail<Copy>(sum, data, len, dest);
+}
+
+template <bool Copy>
+__attribute__((target("avx2"))) uint64_t sum_avx2(const char *data, size_t len, char *dest) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i acc = zero;
+    for (; len >= 32; data += 32, dest += Copy ? 32 : 0, len -= 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data));
+        if (Copy) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dest), v);
+        }
+        acc = _mm256_add_epi64(acc, _mm256_unpacklo_epi32(v, zero));
+        acc = _mm256_add_epi64(acc, _mm256_unpackhi_epi32(v, zero));
+    }
+    alignas(32) array<uint64_t, 4> lanes{};
+    _mm256_store_si256(reinterpret_cast<__m256i *>(lanes.data()), acc);
+    const uint64_t sum = add_with_carry(add_with_carry(lanes[0], lanes[1]), add_with_carry(lanes[2], lanes[3]));
+    // clear the upper halves of the registers, or every SSE instruction after this (in sum_sse2, or
+    // in memcpy and malloc after the call) pays for mixing AVX and legacy SSE code
+    _mm256_zeroupper();
+    return add_with_carry(sum, sum_sse2<Copy>(data, len, dest));
+}
+#endif
+
+//! Fold a sum of native-endian words to the 16-bit sum of big-endian words
+uint16_t fold(uint64_t sum) {
+    while (sum > 0xffff) {
+        sum = (sum >> 16) + (sum & 0xffff);
+    }
+    return ntohs(static_cast<uint16_t>(sum));
+}
+
+}  // namespace
+
+//! \details The data may start at an odd offset from the start of what is being summed: its sum
+//! then has its bytes swapped before it is added.
+void InternetChecksum::add(std::string_view data) { add_sum(sum<false>(data, nullptr), data.size()); }
+
+//! \details The bytes are copied as they are loaded to be summed, so a payload that has to be
+//! copied anyway (into or out of a ByteStream, say) is only read once.
+//! \param[out] dest is where to copy `data`; it must have room for `data.size()` bytes and not overlap it
+//! \param[in] data is the bytes to add and copy
+void InternetChecksum::add_copy(char *dest, std::string_view data) {
+    // split stores are slow: align the destination first (a split at an odd offset is fine, as for add())
+    const size_t head = min(data.size(), -reinterpret_cast<uintptr_t>(dest) % 32);
+    if (head > 0 and data.size() >= 128) {
+        add_sum(sum<true>(data.substr(0, head), dest), head);
+        dest += head;
+        data.remove_prefix(head);
     }
+    add_sum(sum<true>(data, dest), data.size());
+}
+
+template <bool Copy>
+uint64_t InternetChecksum::sum(const std::string_view data, char *dest) const {
+    switch (_kernel) {
+#if defined(__x86_64__)
+        case Kernel::AVX2:
+            return sum_avx2<Copy>(data.data(), data.size(), dest);
+        case Kernel::SSE2:
+            return sum_sse2<Copy>(data.data(), data.size(), dest);
+#endif
+        default:
+            return sum_portable<Copy>(data.data(), data.size(), dest);
+    }
+}
+
+void InternetChecksum::add_sum(const uint64_t sum, const size_t len) {
+    uint16_t val = fold(sum);
+    if (_parity) {
+        val = static_cast<uint16_t>((val << 8) | (val >> 8));
+    }
+    _sum += val;
+    _parity = _parity != (len % 2 == 1);
+}
+
+//! \details This is how a checksum is updated without summing again what did not change
+//! ([RFC 1624](\ref rfc::rfc1624)): e.g. a payload summed once, with a header that changed.
+void InternetChecksum::add(const InternetChecksum &other) {
+    uint64_t val = other._sum;
+    while (val > 0xffff) {
+        val = (val >> 16) + (val & 0xffff);
+    }
+    if (_parity) {
+        val = ((val << 8) | (val >> 8)) & 0xffff;
+    }
+    _sum += val;
+    _parity = _parity != other._parity;
 }
 
 uint16_t InternetChecksum::value() const {
-    uint32_t ret = _sum;
+    uint64_t ret = _sum;
 
     while (ret > 0xffff) {
         ret = (ret >> 16) + (ret & 0xffff);
@@ -107,6 +263,30 @@ uint16_t InternetChecksum::value() const {
     return ~ret;
 }
 
+bool InternetChecksum::supported(const Kernel kernel) {
+    switch (kernel) {
+#if defined(__x86_64__)
+        case Kernel::AVX2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+        case Kernel::SSE2:
+            return true;
+#endif
+        case Kernel::Portable:
+            return true;
+        default:
+            return false;
+    }
+}
+
+//! \details Decided once, on first use
+InternetChecksum::Kernel InternetChecksum::best_kernel() {
+    static const Kernel best = supported(Kernel::AVX2) ? Kernel::AVX2
+                               : supported(Kernel::SSE2) ? Kernel::SSE2
+                                                         : Kernel::Portable;
+    return best;
+}
+
 //! \param[in] data is a pointer to the bytes to show
 //! \param[in] len is the number of bytes to show
 //! \param[in] indent is the number of spaces to indent
@@ -9,6 +9,7 @@
 #include <ostream>
 #include <random>
 #include <string>
+#include <string_view>
 #include <system_error>
 #include <vector>
 
@@ -53,14 +54,40 @@ uint64_t timestamp_ms();
 
 //! The internet checksum algorithm
 class InternetChecksum {
+  public:
+    //! Implementations of the summing loop, from slowest to fastest
+    enum class Kernel {
+        Portable,  //!< 64-bit words with an end-around carry
+        SSE2,      //!< 128-bit vectors (x86-64 only)
+        AVX2       //!< 256-bit vectors (x86-64 CPUs that support AVX2 only)
+    };
+
   private:
-    uint32_t _sum;
+    uint64_t _sum;
     bool _parity{};
+    Kernel _kernel;
+
+    //! Run the kernel over `data` (copying it to `dest` if `Copy`) \returns the unfolded sum
+    template <bool Copy>
+    uint64_t sum(const std::string_view data, char *dest) const;
+
+    //! Add the unfolded sum of `len` bytes that come next
+    void add_sum(const uint64_t sum, const size_t len);
 
   public:
-    InternetChecksum(const uint32_t initial_sum = 0);
+    InternetChecksum(const uint32_t initial_sum = 0, const Kernel kernel = best_kernel());
     void add(std::string_view data);
+    //! Add `data` and copy it to `dest`, in a single pass over the bytes
+    void add_copy(char *dest, std::string_view data);
+    //! Add data summed separately (from an even offset, including its initial sum), as if it came next
+    void add(const InternetChecksum &other);
     uint16_t value() const;
+
+    //! Can `kernel` run on this CPU?
+    static bool supported(const Kernel kernel);
+
+    //! The fastest kernel this CPU supports
+    static Kernel best_kernel();
 };
 
 //! Hexdump the contents of a packet (or any other sequence of bytes)
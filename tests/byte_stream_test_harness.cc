@@ -46,7 +46,9 @@ void ByteStreamAction::execute(ByteStream &) const {}
 ByteStreamAction::~ByteStreamAction() {}
 
 ByteStreamTestHarness::ByteStreamTestHarness(const std::string &test_name, const size_t capacity)
-    : _test_name(test_name), _byte_stream(capacity) {
+    : _test_name(test_name)
+    , _byte_stream(capacity, ByteStream::StorageMode::Ring)
+    , _chunked_byte_stream(capacity, ByteStream::StorageMode::Chunks) {
     std::ostringstream ss;
     ss << "Initialized with ("
        << "capacity=" << capacity << ")";
@@ -54,11 +56,14 @@ ByteStreamTestHarness::ByteStreamTestHarness(const std::string &test_name, const
 }
 
 void ByteStreamTestHarness::execute(const ByteStreamTestStep &step) {
+    std::string mode = "ring";
     try {
         step.execute(_byte_stream);
+        mode = "chunk";
+        step.execute(_chunked_byte_stream);
         _steps_executed.emplace_back(step);
     } catch (const ByteStreamExpectationViolation &e) {
-        std::cerr << "Test Failure on expectation:\n\t" << std::string(step);
+        std::cerr << "Test Failure (" << mode << " storage) on expectation:\n\t" << std::string(step);
         std::cerr << "\n\nFailure message:\n\t" << e.what();
         std::cerr << "\n\nList of steps that executed successfully:";
         for (const std::string &s : _steps_executed) {
@@ -67,7 +72,7 @@ void ByteStreamTestHarness::execute(const ByteStreamTestStep &step) {
         std::cerr << std::endl << std::endl;
         throw ByteStreamExpectationViolation("The test \"" + _test_name + "\" failed");
     } catch (const exception &e) {
-        std::cerr << "Test Failure on expectation:\n\t" << std::string(step);
+        std::cerr << "Test Failure (" << mode << " storage) on expectation:\n\t" << std::string(step);
         std::cerr << "\n\nException:\n\t" << e.what();
         std::cerr << "\n\nList of steps that executed successfully:";
         for (const std::string &s : _steps_executed) {
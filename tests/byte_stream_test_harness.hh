@@ -128,9 +128,11 @@ struct Peek : public ByteStreamExpectation {
     void execute(ByteStream &) const override;
 };
 
+//! Runs every step against a ring-backed and a chunk-backed ByteStream
 class ByteStreamTestHarness {
     std::string _test_name;
     ByteStream _byte_stream;
+    ByteStream _chunked_byte_stream;
     std::vector<std::string> _steps_executed{};
 
   public:
@@ -0,0 +1,110 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+//! A data segment from the peer, acknowledging everything the connection sent during the handshake
+static SendSegment data_segment(const WrappingInt32 seqno, const WrappingInt32 ackno, const string &data) {
+    return SendSegment{}.with_ack(true).with_seqno(seqno).with_ackno(ackno).with_win(1000).with_data(string(data));
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        TCPConfig cfg{};
+        cfg.delayed_ack = true;
+        cfg.ack_delay = 40;
+
+        // test 1: a lone segment is acknowledged once the delay runs out
+        {
+            const WrappingInt32 tx_isn(rd());
+            const WrappingInt32 rx_isn(rd());
+            TCPTestHarness test_1 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+
+            test_1.execute(data_segment(rx_isn + 1, tx_isn + 1, "hello"));
+            test_1.execute(ExpectNoSegment{}, "test 1 failed: ACK was not delayed");
+            test_1.execute(Tick(39));
+            test_1.execute(ExpectNoSegment{}, "test 1 failed: ACK was sent before the delay ran out");
+            test_1.execute(Tick(1));
+            test_1.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 6).with_payload_size(0),
+                           "test 1 failed: delayed ACK was not sent");
+            test_1.execute(Tick(100));
+            test_1.execute(ExpectNoSegment{}, "test 1 failed: delayed ACK was sent twice");
+        }
+
+        // test 2: every second full-sized segment is acknowledged at once
+        {
+            const WrappingInt32 tx_isn(rd());
+            const WrappingInt32 rx_isn(rd());
+            cfg.recv_capacity = 8 * MSS;
+            TCPTestHarness test_2 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+
+            const string full(MSS, 'x');
+            test_2.execute(data_segment(rx_isn + 1, tx_isn + 1, full));
+            test_2.execute(ExpectNoSegment{}, "test 2 failed: ACK for the first segment was not delayed");
+            test_2.execute(data_segment(rx_isn + 1 + MSS, tx_isn + 1, full));
+            test_2.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 1 + 2 * MSS),
+                           "test 2 failed: second full segment was not acknowledged at once");
+            test_2.execute(data_segment(rx_isn + 1 + 2 * MSS, tx_isn + 1, full));
+            test_2.execute(ExpectNoSegment{}, "test 2 failed: the count did not start again");
+        }
+
+        // test 3: out-of-order segments, and the segment that fills the hole, are acknowledged at once
+        {
+            const WrappingInt32 tx_isn(rd());
+            const WrappingInt32 rx_isn(rd());
+            TCPTestHarness test_3 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+
+            test_3.execute(data_segment(rx_isn + 6, tx_isn + 1, "world"));
+            test_3.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 1),
+                           "test 3 failed: out-of-order segment was not acknowledged at once");
+            test_3.execute(data_segment(rx_isn + 1, tx_isn + 1, "hello"));
+            test_3.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 11),
+                           "test 3 failed: segment filling the hole was not acknowledged at once");
+        }
+
+        // test 4: data going out carries the pending ACK
+        {
+            const WrappingInt32 tx_isn(rd());
+            const WrappingInt32 rx_isn(rd());
+            TCPTestHarness test_4 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+
+            test_4.execute(data_segment(rx_isn + 1, tx_isn + 1, "ping"));
+            test_4.execute(ExpectNoSegment{});
+            test_4.execute(Write{"pong"});
+            test_4.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 5).with_data("pong"),
+                           "test 4 failed: reply did not carry the ACK");
+            test_4.execute(Tick(40));
+            test_4.execute(ExpectNoSegment{}, "test 4 failed: ACK was sent again after the reply carried it");
+        }
+
+        // test 5: a FIN is acknowledged at once
+        {
+            const WrappingInt32 tx_isn(rd());
+            const WrappingInt32 rx_isn(rd());
+            TCPTestHarness test_5 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+
+            test_5.execute(data_segment(rx_isn + 1, tx_isn + 1, "bye").with_fin(true));
+            test_5.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 5),
+                           "test 5 failed: FIN was not acknowledged at once");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,174 @@
+#include "byte_stream.hh"
+#include "fsm_stream_reassembler_harness.hh"
+#include "stream_reassembler.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static constexpr unsigned NREPS = 64;
+static constexpr unsigned NSEGS = 256;
+static constexpr unsigned CAPACITY = 4000;
+
+//! Check the reassembler's counters against a byte-by-byte model of which indices are stored
+void check_counters(const StreamReassembler &buf, const vector<bool> &stored) {
+    size_t bytes = 0;
+    size_t holes = 0;
+    optional<uint64_t> highest;
+    const size_t first_unassembled = buf.stream_out().bytes_written();
+    for (size_t i = first_unassembled; i < stored.size(); i++) {
+        if (stored[i]) {
+            bytes++;
+            holes += i == first_unassembled or not stored[i - 1];
+            highest = i;
+        }
+    }
+    if (buf.unassembled_bytes() != bytes) {
+        throw runtime_error("unassembled_bytes() is " + to_string(buf.unassembled_bytes()) + ", expected " +
+                            to_string(bytes));
+    }
+    if (buf.holes() != holes) {
+        throw runtime_error("holes() is " + to_string(buf.holes()) + ", expected " + to_string(holes));
+    }
+    if (buf.highest_buffered_index() != highest) {
+        throw runtime_error("highest_buffered_index() is wrong");
+    }
+    if (buf.unassembled_fragments() < holes) {
+        throw runtime_error("unassembled_fragments() is smaller than holes()");
+    }
+    if (buf.empty() != (bytes == 0)) {
+        throw runtime_error("empty() disagrees with unassembled_bytes()");
+    }
+}
+
+int main() {
+    try {
+        {
+            ReassemblerTestHarness test{65000};
+
+            test.execute(Holes{0});
+            test.execute(HighestBufferedIndex{nullopt});
+
+            test.execute(SubmitSegment{"c", 2});
+            test.execute(Holes{1});
+            test.execute(HighestBufferedIndex{2});
+
+            test.execute(SubmitSegment{"e", 4});
+            test.execute(Holes{2});
+            test.execute(HighestBufferedIndex{4});
+            test.execute(UnassembledBytes{2});
+
+            test.execute(SubmitSegment{"d", 3});
+            test.execute(Holes{1});
+            test.execute(UnassembledBytes{3});
+
+            test.execute(SubmitSegment{"gh", 6});
+            test.execute(Holes{2});
+            test.execute(HighestBufferedIndex{7});
+
+            test.execute(SubmitSegment{"ab", 0});
+            test.execute(BytesAssembled{5});
+            test.execute(Holes{1});
+            test.execute(UnassembledBytes{2});
+            test.execute(HighestBufferedIndex{7});
+
+            test.execute(SubmitSegment{"f", 5});
+            test.execute(BytesAssembled{8});
+            test.execute(Holes{0});
+            test.execute(UnassembledBytes{0});
+            test.execute(HighestBufferedIndex{nullopt});
+        }
+
+        {
+            ReassemblerTestHarness test{65000};
+
+            // one segment covering several stored pieces and the gaps between them
+            test.execute(SubmitSegment{"b", 1});
+            test.execute(SubmitSegment{"d", 3});
+            test.execute(SubmitSegment{"f", 5});
+            test.execute(Holes{3});
+            test.execute(SubmitSegment{"bcdefg", 1});
+            test.execute(Holes{1});
+            test.execute(UnassembledBytes{6});
+            test.execute(HighestBufferedIndex{6});
+        }
+
+        // random segments checked against a model, with the window sliding as bytes are read
+        auto rd = get_random_generator();
+        for (const auto mode : {StreamReassembler::StorageMode::Fragments, StreamReassembler::StorageMode::Slab}) {
+            for (unsigned rep_no = 0; rep_no < NREPS; ++rep_no) {
+                StreamReassembler buf{CAPACITY, mode};
+                vector<bool> stored(1, false);
+
+                for (unsigned i = 0; i < NSEGS; ++i) {
+                    const uint64_t first_unassembled = buf.stream_out().bytes_written();
+                    const uint64_t first_unacceptable = buf.stream_out().bytes_read() + CAPACITY;
+                    // a quarter of the segments start at or just before the first unassembled byte
+                    const uint64_t index = rd() % 4 == 0
+                                               ? first_unassembled - rd() % (min<uint64_t>(first_unassembled, 50) + 1)
+                                               : first_unassembled + rd() % (CAPACITY + CAPACITY / 4);
+                    const size_t size = 1 + rd() % 200;
+
+                    buf.push_substring(string(size, 'x'), index, false);
+
+                    stored.resize(max<size_t>(stored.size(), index + size + 1), false);
+                    for (uint64_t j = index; j < min(index + size, first_unacceptable); j++) {
+                        stored[j] = true;
+                    }
+                    check_counters(buf, stored);
+
+                    if (rd() % 4 == 0) {
+                        buf.stream_out().pop_output(buf.stream_out().buffer_size());
+                    }
+                }
+            }
+        }
+
+        // substrings pushed as Buffers (kept as slices of one storage) or views reassemble like strings
+        for (const auto mode : {StreamReassembler::StorageMode::Fragments, StreamReassembler::StorageMode::Slab}) {
+            for (unsigned rep_no = 0; rep_no < NREPS; ++rep_no) {
+                string data(2 * CAPACITY, 0);
+                for (auto &ch : data) {
+                    ch = static_cast<char>(rd());
+                }
+                const Buffer storage{string(data)};
+
+                StreamReassembler buf{CAPACITY, mode};
+                string assembled;
+                for (unsigned i = 0; i < NSEGS; ++i) {
+                    const size_t index = min<size_t>(buf.stream_out().bytes_written() + rd() % 300, data.size());
+                    const size_t size = min<size_t>(1 + rd() % 200, data.size() - index);
+                    if (rd() % 2) {
+                        Buffer slice = storage;
+                        slice.remove_prefix(index);
+                        slice.remove_suffix(slice.size() - size);
+                        buf.push_substring(slice, index, false);
+                    } else {
+                        buf.push_substring(string_view(data).substr(index, size), index, false);
+                    }
+                    assembled += buf.stream_out().read(buf.stream_out().buffer_size());
+                }
+                while (not buf.stream_out().eof()) {
+                    buf.push_substring(storage, 0, true);
+                    assembled += buf.stream_out().read(buf.stream_out().buffer_size());
+                }
+                if (assembled != data) {
+                    throw runtime_error("Buffers and views were not reassembled into the original data");
+                }
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
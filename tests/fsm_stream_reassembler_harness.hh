@@ -7,6 +7,7 @@
 
 #include <exception>
 #include <iostream>
+#include <optional>
 #include <sstream>
 #include <string>
 #include <utility>
@@ -103,6 +104,52 @@ struct UnassembledBytes : public ReassemblerExpectation {
     }
 };
 
+struct Holes : public ReassemblerExpectation {
+    size_t _holes;
+
+    Holes(size_t holes) : _holes(holes) {}
+    std::string description() const {
+        std::ostringstream ss;
+        ss << "holes = " << _holes;
+        return ss.str();
+    }
+
+    void execute(StreamReassembler &reassembler) const {
+        if (reassembler.holes() != _holes) {
+            std::ostringstream ss;
+            ss << "The reassembler was expected to have `" << _holes << "` holes, but there were `"
+               << reassembler.holes() << "`";
+            throw ReassemblerExpectationViolation(ss.str());
+        }
+    }
+};
+
+struct HighestBufferedIndex : public ReassemblerExpectation {
+    std::optional<uint64_t> _index;
+
+    HighestBufferedIndex(std::optional<uint64_t> index) : _index(index) {}
+    std::string description() const {
+        std::ostringstream ss;
+        if (_index.has_value()) {
+            ss << "highest buffered index = " << _index.value();
+        } else {
+            ss << "no buffered bytes";
+        }
+        return ss.str();
+    }
+
+    void execute(StreamReassembler &reassembler) const {
+        const auto index = reassembler.highest_buffered_index();
+        if (index != _index) {
+            std::ostringstream ss;
+            ss << "The reassembler was expected to have highest buffered index `"
+               << (_index.has_value() ? std::to_string(_index.value()) : "none") << "`, but it was `"
+               << (index.has_value() ? std::to_string(index.value()) : "none") << "`";
+            throw ReassemblerExpectationViolation(ss.str());
+        }
+    }
+};
+
 struct AtEof : public ReassemblerExpectation {
     AtEof() {}
     std::string description() const {
@@ -159,21 +206,29 @@ struct SubmitSegment : public ReassemblerAction {
     void execute(StreamReassembler &reassembler) const { reassembler.push_substring(_data, _index, _eof); }
 };
 
+//! Runs every step against a fragment-backed and a slab-backed StreamReassembler
 class ReassemblerTestHarness {
     StreamReassembler reassembler;
+    StreamReassembler slab_reassembler;
     std::vector<std::string> steps_executed;
 
   public:
-    ReassemblerTestHarness(const size_t capacity) : reassembler(capacity), steps_executed() {
+    ReassemblerTestHarness(const size_t capacity)
+        : reassembler(capacity, StreamReassembler::StorageMode::Fragments)
+        , slab_reassembler(capacity, StreamReassembler::StorageMode::Slab)
+        , steps_executed() {
         steps_executed.emplace_back("Initialized (capacity = " + std::to_string(capacity) + ")");
     }
 
     void execute(const ReassemblerTestStep &step) {
+        std::string mode = "fragment";
         try {
             step.execute(reassembler);
+            mode = "slab";
+            step.execute(slab_reassembler);
             steps_executed.emplace_back(step.to_string());
         } catch (const ReassemblerExpectationViolation &e) {
-            std::cerr << "Test Failure on expectation:\n\t" << step.to_string();
+            std::cerr << "Test Failure (" << mode << " storage) on expectation:\n\t" << step.to_string();
             std::cerr << "\n\nFailure message:\n\t" << e.what();
             std::cerr << "\n\nList of steps that executed successfully:";
             for (const std::string &s : steps_executed) {
@@ -182,7 +237,7 @@ class ReassemblerTestHarness {
             std::cerr << std::endl << std::endl;
             throw e;
         } catch (const std::exception &e) {
-            std::cerr << "Test Failure on expectation:\n\t" << step.to_string();
+            std::cerr << "Test Failure (" << mode << " storage) on expectation:\n\t" << step.to_string();
             std::cerr << "\n\nFailure message:\n\t" << e.what();
             std::cerr << "\n\nList of steps that executed successfully:";
             for (const std::string &s : steps_executed) {
@@ -22,13 +22,18 @@ string read(StreamReassembler &reassembler) {
     return reassembler.stream_out().read(reassembler.stream_out().buffer_size());
 }
 
+//! Alternate between the reassembler's storage modes from one repetition to the next
+StreamReassembler::StorageMode storage_mode(const unsigned rep_no) {
+    return rep_no % 2 ? StreamReassembler::StorageMode::Slab : StreamReassembler::StorageMode::Fragments;
+}
+
 int main() {
     try {
         auto rd = get_random_generator();
 
         // buffer a bunch of bytes, make sure we can empty and re-fill before calling close()
         for (unsigned rep_no = 0; rep_no < NREPS; ++rep_no) {
-            StreamReassembler buf{MAX_SEG_LEN * NSEGS};
+            StreamReassembler buf{MAX_SEG_LEN * NSEGS, storage_mode(rep_no)};
 
             vector<tuple<size_t, size_t>> seq_size;
             size_t offset = 0;
@@ -58,7 +63,7 @@ int main() {
 
         // insert EOF into a hole in the buffer
         for (unsigned rep_no = 0; rep_no < NREPS; ++rep_no) {
-            StreamReassembler buf{65'000};
+            StreamReassembler buf{65'000, storage_mode(rep_no)};
 
             const size_t size = 1024;
             string d(size, 0);
@@ -89,7 +94,7 @@ int main() {
 
         // insert EOF over previously queued data, require one of two possible correct actions
         for (unsigned rep_no = 0; rep_no < NREPS; ++rep_no) {
-            StreamReassembler buf{65'000};
+            StreamReassembler buf{65'000, storage_mode(rep_no)};
 
             const size_t size = 1024;
             string d(size, 0);
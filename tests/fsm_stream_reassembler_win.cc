@@ -22,13 +22,18 @@ string read(StreamReassembler &reassembler) {
     return reassembler.stream_out().read(reassembler.stream_out().buffer_size());
 }
 
+//! Alternate between the reassembler's storage modes from one repetition to the next
+StreamReassembler::StorageMode storage_mode(const unsigned rep_no) {
+    return rep_no % 2 ? StreamReassembler::StorageMode::Slab : StreamReassembler::StorageMode::Fragments;
+}
+
 int main() {
     try {
         auto rd = get_random_generator();
 
         // overlapping segments
         for (unsigned rep_no = 0; rep_no < NREPS; ++rep_no) {
-            StreamReassembler buf{NSEGS * MAX_SEG_LEN};
+            StreamReassembler buf{NSEGS * MAX_SEG_LEN, storage_mode(rep_no)};
 
             vector<tuple<size_t, size_t>> seq_size;
             size_t offset = 0;
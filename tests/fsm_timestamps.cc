@@ -0,0 +1,148 @@
+#include "parser.hh"
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+using State = TCPTestHarness::State;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // test 1: both SYNs offer timestamps; they are echoed, measure the RTT and reject old segments
+        {
+            TCPConfig cfg{};
+            cfg.timestamps = true;
+            const WrappingInt32 tx_isn(rd());
+            const WrappingInt32 rx_isn(rd());
+            cfg.fixed_isn = tx_isn;
+
+            TCPTestHarness test_1(cfg);
+            test_1.execute(Connect{});
+            test_1.execute(ExpectOneSegment{}.with_syn(true).with_seqno(tx_isn).with_timestamps(0, 0),
+                           "test 1 failed: SYN should offer timestamps");
+
+            test_1.execute(Tick(10));
+            SendSegment syn_ack{};
+            syn_ack.with_syn(true).with_ack(true).with_seqno(rx_isn).with_ackno(tx_isn + 1).with_win(1000);
+            test_1.execute(syn_ack.with_timestamps(500, 0));
+            test_1.execute(ExpectState{State::ESTABLISHED});
+            test_1.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 1).with_timestamps(10, 500),
+                           "test 1 failed: ACK should echo the SYN/ACK's timestamp");
+            test_err_if(test_1._fsm.latest_rtt() != 10, "test 1 failed: RTT not measured from the echoed timestamp");
+
+            // an older timestamp marks an old duplicate: it is acknowledged, but its data is dropped
+            test_1.execute(Tick(5));
+            SendSegment old_data{};
+            old_data.with_ack(true).with_seqno(rx_isn + 1).with_ackno(tx_isn + 1).with_win(1000).with_data("hello");
+            test_1.execute(old_data.with_timestamps(400, 10));
+            test_1.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 1).with_timestamps(15, 500),
+                           "test 1 failed: PAWS should acknowledge without accepting the segment");
+            test_1.execute(ExpectNoData{});
+
+            SendSegment new_data{};
+            new_data.with_ack(true).with_seqno(rx_isn + 1).with_ackno(tx_isn + 1).with_win(1000).with_data("hello");
+            test_1.execute(new_data.with_timestamps(501, 10));
+            test_1.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 6).with_timestamps(15, 501),
+                           "test 1 failed: a newer timestamp should be accepted and echoed");
+            test_1.execute(ExpectData{}.with_data("hello"));
+        }
+
+        // test 2: the peer offers timestamps, so the SYN/ACK echoes its TSval
+        {
+            TCPConfig cfg{};
+            cfg.timestamps = true;
+            const WrappingInt32 tx_isn(rd());
+            const WrappingInt32 rx_isn(rd());
+            cfg.fixed_isn = tx_isn;
+
+            TCPTestHarness test_2(cfg);
+            test_2.execute(Listen{});
+            test_2.execute(SendSegment{}.with_syn(true).with_seqno(rx_isn).with_timestamps(7, 0));
+            test_2.execute(
+                ExpectOneSegment{}.with_syn(true).with_ack(true).with_ackno(rx_isn + 1).with_timestamps(0, 7),
+                "test 2 failed: SYN/ACK should echo the SYN's timestamp");
+        }
+
+        // test 3: the peer does not offer timestamps, so they are not used
+        {
+            TCPConfig cfg{};
+            cfg.timestamps = true;
+            const WrappingInt32 tx_isn(rd());
+            const WrappingInt32 rx_isn(rd());
+            cfg.fixed_isn = tx_isn;
+
+            TCPTestHarness test_3(cfg);
+            test_3.execute(Listen{});
+            test_3.send_syn(rx_isn);
+            test_3.execute(
+                ExpectOneSegment{}.with_syn(true).with_ack(true).with_ackno(rx_isn + 1).with_timestamps(nullopt),
+                "test 3 failed: SYN/ACK should not carry timestamps without agreement");
+        }
+
+        // test 4: timestamps not configured, so a peer's offer and later timestamps are ignored
+        {
+            TCPConfig cfg{};
+            const WrappingInt32 tx_isn(rd());
+            const WrappingInt32 rx_isn(rd());
+            cfg.fixed_isn = tx_isn;
+
+            TCPTestHarness test_4(cfg);
+            test_4.execute(Listen{});
+            test_4.execute(SendSegment{}.with_syn(true).with_seqno(rx_isn).with_timestamps(7, 0));
+            test_4.execute(
+                ExpectOneSegment{}.with_syn(true).with_ack(true).with_ackno(rx_isn + 1).with_timestamps(nullopt),
+                "test 4 failed: SYN/ACK should not offer timestamps");
+
+            // without agreement, an older timestamp does not make a segment an old duplicate
+            SendSegment data{};
+            data.with_ack(true).with_seqno(rx_isn + 1).with_ackno(tx_isn + 1).with_win(1000).with_data("hello");
+            test_4.execute(data.with_timestamps(3, 0));
+            test_4.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 6).with_timestamps(nullopt),
+                           "test 4 failed: PAWS should not apply without agreement");
+            test_4.execute(ExpectData{}.with_data("hello"));
+        }
+
+        // test 5: beside timestamps, the options field has room for three SACK blocks
+        {
+            TCPHeader header{};
+            header.timestamps = TCPHeader::Timestamps{0xdeadbeef, 0x01020304};
+            for (uint32_t i = 0; i < TCPHeader::MAX_SACK_BLOCKS_WITH_TIMESTAMPS; i++) {
+                header.sack.push_back({WrappingInt32{100 * i}, WrappingInt32{100 * i + 50}});
+            }
+
+            TCPHeader parsed{};
+            NetParser p{Buffer{header.serialize()}};
+            test_err_if(parsed.parse(p) != ParseResult::NoError, "test 5 failed: header did not parse");
+            test_err_if(parsed.timestamps != header.timestamps or not(parsed.sack == header.sack),
+                        "test 5 failed: options did not survive a round trip");
+
+            header.sack.push_back({WrappingInt32{1000}, WrappingInt32{1050}});
+            bool too_long = false;
+            try {
+                header.serialize();
+            } catch (const runtime_error &) {
+                too_long = true;
+            }
+            test_err_if(not too_long, "test 5 failed: four SACK blocks and timestamps should not fit");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return err_num;
+    }
+
+    return EXIT_SUCCESS;
+}
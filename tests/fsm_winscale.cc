@@ -0,0 +1,135 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+using State = TCPTestHarness::State;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // test 1: both SYNs offer scaling; windows are scaled in both directions after the handshake
+        {
+            TCPConfig cfg{};
+            cfg.window_scaling = true;
+            cfg.recv_capacity = 4 * 1024 * 1024;
+            cfg.send_capacity = 256 * 1024;
+            const WrappingInt32 tx_isn(rd());
+            const WrappingInt32 rx_isn(rd());
+            cfg.fixed_isn = tx_isn;
+            test_err_if(cfg.window_shift() != 7, "test 1 failed: wrong window shift for a 4 MiB window");
+
+            TCPTestHarness test_1(cfg);
+            test_1.execute(Connect{});
+            test_1.execute(ExpectOneSegment{}.with_syn(true).with_seqno(tx_isn).with_wscale(7),
+                           "test 1 failed: SYN should offer window scaling");
+
+            SendSegment syn_ack{};
+            syn_ack.with_syn(true).with_ack(true).with_seqno(rx_isn).with_ackno(tx_isn + 1);
+            test_1.execute(syn_ack.with_win(1000).with_wscale(4));
+            test_1.execute(ExpectState{State::ESTABLISHED});
+            test_1.execute(
+                ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 1).with_win(32768).with_wscale(nullopt),
+                "test 1 failed: ACK should advertise the scaled receive window");
+
+            // the window in the SYN/ACK was not scaled
+            string d(100000, 0);
+            generate(d.begin(), d.end(), [&] { return rd(); });
+            test_1.execute(Write{d}.with_bytes_written(d.size()));
+            test_1.execute(Tick(1));
+            test_1.execute(ExpectBytesInFlight{1000}, "test 1 failed: the SYN's window must not be scaled");
+
+            // later windows are scaled by the peer's shift
+            test_1.execute(SendSegment{}.with_ack(true).with_seqno(rx_isn + 1).with_ackno(tx_isn + 1).with_win(5000));
+            test_1.execute(Tick(1));
+            test_1.execute(ExpectBytesInFlight{5000 << 4}, "test 1 failed: peer's window not scaled");
+        }
+
+        // test 2: the peer does not offer scaling, so neither side scales
+        {
+            TCPConfig cfg{};
+            cfg.window_scaling = true;
+            cfg.recv_capacity = 4 * 1024 * 1024;
+            const WrappingInt32 tx_isn(rd());
+            const WrappingInt32 rx_isn(rd());
+            cfg.fixed_isn = tx_isn;
+
+            TCPTestHarness test_2(cfg);
+            test_2.execute(Listen{});
+            test_2.send_syn(rx_isn);
+            test_2.execute(ExpectOneSegment{}
+                               .with_syn(true)
+                               .with_ack(true)
+                               .with_ackno(rx_isn + 1)
+                               .with_win(65535)
+                               .with_wscale(nullopt),
+                           "test 2 failed: SYN/ACK must not offer scaling to a peer that did not");
+            test_2.send_ack(rx_isn + 1, tx_isn + 1, 3000);
+            test_2.execute(ExpectState{State::ESTABLISHED});
+
+            string d(10000, 0);
+            generate(d.begin(), d.end(), [&] { return rd(); });
+            test_2.execute(Write{d}.with_bytes_written(d.size()));
+            test_2.execute(Tick(1));
+            test_2.execute(ExpectBytesInFlight{3000}, "test 2 failed: peer's window scaled without agreement");
+            test_2.execute(ExpectSegment{}.with_ack(true).with_win(65535),
+                           "test 2 failed: receive window should be clamped without scaling");
+        }
+
+        // test 3: the peer offers scaling first, so the SYN/ACK offers it back
+        {
+            TCPConfig cfg{};
+            cfg.window_scaling = true;
+            cfg.recv_capacity = 4 * 1024 * 1024;
+            const WrappingInt32 tx_isn(rd());
+            const WrappingInt32 rx_isn(rd());
+            cfg.fixed_isn = tx_isn;
+
+            TCPTestHarness test_3(cfg);
+            test_3.execute(Listen{});
+            test_3.execute(SendSegment{}.with_syn(true).with_seqno(rx_isn).with_win(1000).with_wscale(2));
+            test_3.execute(
+                ExpectOneSegment{}.with_syn(true).with_ack(true).with_ackno(rx_isn + 1).with_win(65535).with_wscale(7),
+                "test 3 failed: SYN/ACK should offer scaling back");
+            test_3.send_ack(rx_isn + 1, tx_isn + 1, 3000);
+            test_3.execute(ExpectState{State::ESTABLISHED});
+
+            string d(20000, 0);
+            generate(d.begin(), d.end(), [&] { return rd(); });
+            test_3.execute(Write{d}.with_bytes_written(d.size()));
+            test_3.execute(Tick(1));
+            test_3.execute(ExpectBytesInFlight{3000 << 2}, "test 3 failed: peer's window not scaled");
+        }
+
+        // test 4: scaling not configured, so the SYN carries no option
+        {
+            TCPConfig cfg{};
+            const WrappingInt32 tx_isn(rd());
+            cfg.fixed_isn = tx_isn;
+
+            TCPTestHarness test_4(cfg);
+            test_4.execute(Connect{});
+            test_4.execute(ExpectOneSegment{}.with_syn(true).with_seqno(tx_isn).with_wscale(nullopt),
+                           "test 4 failed: SYN should not offer window scaling");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return err_num;
+    }
+
+    return EXIT_SUCCESS;
+}
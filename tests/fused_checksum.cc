@@ -0,0 +1,148 @@
+#include "byte_stream.hh"
+#include "stream_reassembler.hh"
+#include "tcp_receiver.hh"
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace std;
+
+static constexpr uint32_t PSEUDO_CHECKSUM = 0x1234;
+
+static string random_string(const size_t size, mt19937 &rd) {
+    string data(size, 0);
+    for (auto &c : data) {
+        c = static_cast<char>(rd());
+    }
+    return data;
+}
+
+//! A data segment as parse() leaves it with its payload checksum deferred, with a byte of the
+//! payload flipped on the way if `corrupt`
+static TCPSegment received(const WrappingInt32 seqno, const string &payload, const bool corrupt = false) {
+    TCPSegment seg;
+    seg.header().seqno = seqno;
+    seg.header().ack = true;
+    seg.payload() = string(payload);
+    string wire = seg.serialize(PSEUDO_CHECKSUM).concatenate();
+    if (corrupt) {
+        wire.back() ^= 0x10;
+    }
+
+    TCPSegment parsed;
+    test_err_if(parsed.parse(move(wire), PSEUDO_CHECKSUM, true) != ParseResult::NoError, "segment did not parse");
+    test_err_if(not parsed.deferred_checksum().has_value(), "a data segment's checksum was not deferred");
+    return parsed;
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // reading while summing gives the bytes and their sum, across the end of the ring
+        for (const auto mode : {ByteStream::StorageMode::Ring, ByteStream::StorageMode::Chunks}) {
+            ByteStream stream{1000, mode};
+            for (size_t round = 0; round < 50; round++) {
+                const string data = random_string(uniform_int_distribution<size_t>{1, 700}(rd), rd);
+                stream.write(data);
+                InternetChecksum expected;
+                expected.add(data);
+
+                InternetChecksum sum;
+                const BufferList read = stream.read_buffers(data.size(), sum);
+                test_err_if(read.concatenate() != data, "read_buffers with a checksum returned the wrong bytes");
+                test_err_if(sum.value() != expected.value(), "read_buffers with a checksum got the wrong sum");
+            }
+        }
+
+        // staged bytes are only written once committed, and dropped by any other write
+        for (const auto mode : {ByteStream::StorageMode::Ring, ByteStream::StorageMode::Chunks}) {
+            ByteStream stream{8, mode};
+            stream.write(string{"abcdef"});
+            stream.pop_output(6);
+            InternetChecksum sum;
+            stream.stage(Buffer{"ghijk"}, sum);
+            test_err_if(stream.buffer_size() != 0, "staged bytes were readable");
+            stream.commit();
+            test_err_if(stream.read(8) != "ghijk", "committed bytes were wrong");
+
+            stream.stage(Buffer{"lm"}, sum);
+            stream.write(string{"no"});
+            stream.commit();
+            test_err_if(stream.read(8) != "no", "staged bytes survived another write");
+        }
+
+        // only data segments have their checksum deferred, and it still catches corruption
+        {
+            const string payload = random_string(500, rd);
+            test_err_if(not received(WrappingInt32{1}, payload).verify_deferred_checksum(), "a good segment failed");
+            test_err_if(received(WrappingInt32{1}, payload, true).verify_deferred_checksum(),
+                        "a corrupt segment passed");
+
+            TCPSegment syn;
+            syn.header().syn = true;
+            syn.payload() = string(payload);
+            TCPSegment parsed;
+            test_err_if(parsed.parse(syn.serialize(PSEUDO_CHECKSUM).concatenate(), PSEUDO_CHECKSUM, true) !=
+                            ParseResult::NoError,
+                        "SYN did not parse");
+            test_err_if(parsed.deferred_checksum().has_value(), "a SYN's checksum was deferred");
+        }
+
+        // the reassembler keeps nothing of a corrupt substring, wherever it falls
+        for (const auto mode : {StreamReassembler::StorageMode::Fragments, StreamReassembler::StorageMode::Slab}) {
+            StreamReassembler reassembler{64, mode};
+            const string data = random_string(48, rd);
+            const auto push = [&](const size_t first, const size_t last, const bool corrupt) {
+                const TCPSegment seg = received(WrappingInt32{0}, data.substr(first, last - first), corrupt);
+                return reassembler.push_substring(seg.payload(), first, false, seg.deferred_checksum().value());
+            };
+
+            test_err_if(push(0, 16, true), "a corrupt in-order substring was accepted");
+            test_err_if(reassembler.stream_out().bytes_written() != 0, "a corrupt in-order substring was written");
+            test_err_if(push(24, 32, true), "a corrupt out-of-order substring was accepted");
+            test_err_if(reassembler.unassembled_bytes() != 0, "a corrupt out-of-order substring was stored");
+
+            test_err_if(not push(24, 32, false), "a good out-of-order substring was rejected");
+            test_err_if(reassembler.unassembled_bytes() != 8, "a good out-of-order substring was not stored");
+            test_err_if(not push(0, 16, false), "a good in-order substring was rejected");
+            test_err_if(push(8, 28, true), "a corrupt overlapping substring was accepted");
+            test_err_if(reassembler.stream_out().bytes_written() != 16, "a corrupt overlapping substring was written");
+            test_err_if(not push(8, 28, false), "a good overlapping substring was rejected");
+            test_err_if(reassembler.stream_out().bytes_written() != 32, "the stored substring was not assembled");
+            test_err_if(reassembler.unassembled_bytes() != 0, "assembled bytes are still counted");
+            test_err_if(not push(32, 48, false), "a good in-order substring was rejected");
+            test_err_if(reassembler.stream_out().read(64) != data, "the stream holds the wrong bytes");
+        }
+
+        // the receiver ignores a corrupt segment, and acknowledges a good one
+        {
+            const WrappingInt32 isn(rd());
+            TCPReceiver receiver{4000};
+            TCPSegment syn;
+            syn.header().syn = true;
+            syn.header().seqno = isn;
+            test_err_if(not receiver.segment_received(syn), "the SYN was ignored");
+
+            const string payload = random_string(1000, rd);
+            test_err_if(receiver.segment_received(received(isn + 1, payload, true)), "a corrupt segment was taken");
+            test_err_if(receiver.ackno() != isn + 1, "a corrupt segment was acknowledged");
+            test_err_if(not receiver.segment_received(received(isn + 1, payload)), "a good segment was ignored");
+            test_err_if(receiver.ackno() != isn + 1001, "a good segment was not acknowledged");
+            test_err_if(receiver.stream_out().read(1000) != payload, "the stream holds the wrong bytes");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return err_num;
+    }
+
+    return EXIT_SUCCESS;
+}
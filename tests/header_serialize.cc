@@ -0,0 +1,237 @@
+#include "arp_message.hh"
+#include "buffer.hh"
+#include "ethernet_header.hh"
+#include "ipv4_datagram.hh"
+#include "parser.hh"
+#include "tcp_over_ip.hh"
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+#include "wrapping_integers.hh"
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+static string random_string(const size_t size, mt19937 &rd) {
+    string data(size, 0);
+    for (auto &c : data) {
+        c = static_cast<char>(rd());
+    }
+    return data;
+}
+
+//! A header with random fields and a random choice of options: those of a SYN, or SACK blocks
+static TCPHeader random_tcp_header(mt19937 &rd) {
+    TCPHeader header;
+    header.sport = rd();
+    header.dport = rd();
+    header.seqno = WrappingInt32(rd());
+    header.ackno = WrappingInt32(rd());
+    header.doff = uniform_int_distribution<unsigned>{5, 8}(rd);
+    header.ack = rd() % 2;
+    header.psh = rd() % 2;
+    header.win = rd();
+    header.cksum = rd();
+    header.sack_permitted = rd() % 2;
+    if (rd() % 2) {
+        header.wscale = rd() % (TCPHeader::MAX_WINDOW_SHIFT + 1);
+    }
+    if (rd() % 2) {
+        header.timestamps = TCPHeader::Timestamps{static_cast<uint32_t>(rd()), static_cast<uint32_t>(rd())};
+    }
+    if (header.sack_permitted or header.wscale.has_value()) {
+        return header;
+    }
+    const size_t max_blocks =
+        header.timestamps.has_value() ? TCPHeader::MAX_SACK_BLOCKS_WITH_TIMESTAMPS : TCPHeader::MAX_SACK_BLOCKS;
+    const size_t blocks = uniform_int_distribution<size_t>{0, max_blocks}(rd);
+    for (size_t i = 0; i < blocks; i++) {
+        header.sack.push_back({WrappingInt32(rd()), WrappingInt32(rd())});
+    }
+    return header;
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // serializing into a fixed-size array gives the same bytes as the string, and they parse back
+        for (size_t round = 0; round < 1000; round++) {
+            const TCPHeader header = random_tcp_header(rd);
+            const string expected = header.serialize();
+            test_err_if(header.serialized_length() != expected.size(), "TCP serialized_length() is wrong");
+            test_err_if(expected.size() % 4 != 0 or expected.size() > TCPHeader::MAX_LENGTH,
+                        "TCP header is a bad size");
+
+            array<char, TCPHeader::MAX_LENGTH> out;
+            out.fill('x');
+            header.serialize_into(out.data());
+            test_err_if(string(out.data(), expected.size()) != expected,
+                        "TCP serialize_into() disagrees with serialize()");
+            test_err_if(expected.size() < out.size() and out[expected.size()] != 'x', "TCP serialize_into() overran");
+
+            TCPHeader parsed;
+            NetParser p{Buffer{string(expected)}};
+            test_err_if(parsed.parse(p) != ParseResult::NoError, "TCP header did not parse");
+            test_err_if(parsed.sack != header.sack or parsed.timestamps != header.timestamps or
+                            parsed.wscale != header.wscale or parsed.sack_permitted != header.sack_permitted,
+                        "TCP options did not survive a round trip");
+        }
+
+        // a segment's header, serialized with its checksum into place, parses with its payload
+        for (size_t round = 0; round < 200; round++) {
+            TCPSegment seg;
+            seg.header() = random_tcp_header(rd);
+            seg.payload() = random_string(uniform_int_distribution<size_t>{0, 1500}(rd), rd);
+            const uint32_t pseudo_checksum = rd() & 0xffff;
+
+            string wire(seg.header_length(), 0);
+            seg.serialize_header_into(wire.data(), pseudo_checksum);
+            wire.append(seg.payload().str());
+            test_err_if(wire != seg.serialize(pseudo_checksum).concatenate(), "TCP segment serializations disagree");
+
+            TCPSegment parsed;
+            test_err_if(parsed.parse(move(wire), pseudo_checksum) != ParseResult::NoError, "TCP segment did not parse");
+            test_err_if(parsed.payload().str() != seg.payload().str(), "TCP payload did not survive a round trip");
+        }
+
+        // an IPv4 header with its checksum filled in place, with and without options
+        for (const uint8_t hlen : {5, 6, 15}) {
+            IPv4Header header;
+            header.hlen = hlen;
+            header.len = 4 * hlen;
+            header.id = rd();
+            header.src = rd();
+            header.dst = rd();
+            header.cksum = rd();
+
+            array<char, IPv4Header::MAX_LENGTH> out;
+            header.serialize_into(out.data(), true);
+            const string wire(out.data(), 4 * hlen);
+            InternetDatagram parsed;
+            test_err_if(parsed.parse(string(wire)) != ParseResult::NoError, "IPv4 header did not parse");
+
+            InternetDatagram dgram;
+            dgram.header() = header;
+            test_err_if(dgram.serialize().concatenate() != wire, "IPv4 serializations disagree");
+            header.serialize_into(out.data());
+            test_err_if(string(out.data(), 4 * hlen) != header.serialize(),
+                        "IPv4 serialize_into() disagrees with serialize()");
+        }
+
+        // an Ethernet header
+        {
+            EthernetHeader header{{1, 2, 3, 4, 5, 6}, {7, 8, 9, 10, 11, 12}, EthernetHeader::TYPE_IPv4};
+            array<char, EthernetHeader::LENGTH> out;
+            header.serialize_into(out.data());
+            test_err_if(string(out.data(), out.size()) != header.serialize(), "Ethernet serializations disagree");
+            const string expected{"\x01\x02\x03\x04\x05\x06\x07\x08\x09\x0a\x0b\x0c\x08\x00", 14};
+            test_err_if(string(out.data(), out.size()) != expected, "Ethernet header has the wrong bytes");
+        }
+
+        // headers prepended into a headroom buffer make the same datagram as wrap_tcp_in_ip()
+        {
+            TCPOverIPv4Adapter adapter;
+            adapter.config_mut().source = {"10.0.0.1", 1234};
+            adapter.config_mut().destination = {"10.0.0.2", 5678};
+            for (size_t round = 0; round < 100; round++) {
+                TCPSegment seg;
+                seg.header() = random_tcp_header(rd);
+                seg.payload() = random_string(uniform_int_distribution<size_t>{0, 1500}(rd), rd);
+
+                TCPOverIPv4Adapter::HeaderBuffer headers;
+                adapter.prepend_tcp_in_ip_headers(seg, headers);
+                const string expected = adapter.wrap_tcp_in_ip(seg).serialize().concatenate();
+                test_err_if(string(headers.str()) + string(seg.payload().str()) != expected,
+                            "prepended headers disagree with wrap_tcp_in_ip()");
+
+                InternetDatagram parsed;
+                test_err_if(parsed.parse(string(expected)) != ParseResult::NoError, "wrapped datagram did not parse");
+                TCPSegment parsed_seg;
+                test_err_if(parsed_seg.parse(parsed.payload().concatenate(), parsed.header().pseudo_cksum()) !=
+                                ParseResult::NoError,
+                            "wrapped segment did not parse");
+            }
+        }
+
+        // every header parses back from its own bytes, and not from any prefix of them
+        for (size_t round = 0; round < 100; round++) {
+            TCPHeader tcp = random_tcp_header(rd);
+            const string tcp_wire = tcp.serialize();
+            tcp.doff = tcp_wire.size() / 4;
+
+            ARPMessage arp;
+            arp.opcode = ARPMessage::OPCODE_REPLY;
+            arp.sender_ethernet_address = {1, 2, 3, 4, 5, 6};
+            arp.sender_ip_address = rd();
+            arp.target_ip_address = rd();
+            const string arp_wire = arp.serialize();
+
+            EthernetHeader ethernet{{1, 2, 3, 4, 5, 6}, {7, 8, 9, 10, 11, 12}, EthernetHeader::TYPE_ARP};
+            const string ethernet_wire = ethernet.serialize();
+
+            for (size_t length = 0; length <= tcp_wire.size(); length++) {
+                TCPHeader parsed;
+                NetParser p{tcp_wire.substr(0, length)};
+                const ParseResult result = parsed.parse(p);
+                if (length < tcp_wire.size()) {
+                    test_err_if(result == ParseResult::NoError, "a truncated TCP header parsed");
+                } else {
+                    test_err_if(result != ParseResult::NoError or not(parsed == tcp),
+                                "a TCP header did not parse back");
+                    test_err_if(p.size() != 0, "parsing a TCP header left bytes behind");
+                }
+            }
+            for (size_t length = 0; length <= arp_wire.size(); length++) {
+                ARPMessage parsed;
+                const ParseResult result = parsed.parse(arp_wire.substr(0, length));
+                test_err_if((result == ParseResult::NoError) != (length == arp_wire.size()),
+                            "an ARP message misparsed");
+                if (result == ParseResult::NoError) {
+                    test_err_if(parsed.serialize() != arp_wire, "an ARP message did not parse back");
+                }
+            }
+            for (size_t length = 0; length <= ethernet_wire.size(); length++) {
+                EthernetHeader parsed;
+                NetParser p{ethernet_wire.substr(0, length)};
+                const ParseResult result = parsed.parse(p);
+                test_err_if((result == ParseResult::NoError) != (length == ethernet_wire.size()),
+                            "an Ethernet header misparsed");
+                if (result == ParseResult::NoError) {
+                    test_err_if(parsed.serialize() != ethernet_wire, "an Ethernet header did not parse back");
+                }
+            }
+        }
+
+        // the headroom runs out rather than overflowing
+        {
+            HeadroomBuffer<8> headers;
+            NetUnparser::u32(headers.prepend(4), 0x01020304);
+            NetUnparser::u16(headers.prepend(2), 0x0506);
+            test_err_if(headers.str() != string("\x05\x06\x01\x02\x03\x04", 6),
+                        "headroom buffer holds the wrong bytes");
+            bool threw = false;
+            try {
+                headers.prepend(3);
+            } catch (const runtime_error &) {
+                threw = true;
+            }
+            test_err_if(not threw or headers.size() != 6, "headroom buffer overflowed");
+            headers.clear();
+            test_err_if(headers.size() != 0 or headers.prepend(8) == nullptr, "cleared headroom buffer is not empty");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return err_num;
+    }
+
+    return EXIT_SUCCESS;
+}
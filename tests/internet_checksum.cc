@@ -0,0 +1,163 @@
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+using Kernel = InternetChecksum::Kernel;
+
+//! The checksum one byte at a time, as the big-endian 16-bit words of the definition
+static uint16_t reference_checksum(const uint32_t initial_sum, const string &data) {
+    uint64_t sum = initial_sum;
+    for (size_t i = 0; i < data.size(); i++) {
+        const uint64_t byte = static_cast<uint8_t>(data[i]);
+        sum += i % 2 == 0 ? byte << 8 : byte;
+    }
+    while (sum > 0xffff) {
+        sum = (sum >> 16) + (sum & 0xffff);
+    }
+    return ~sum;
+}
+
+static string kernel_name(const Kernel kernel) {
+    switch (kernel) {
+        case Kernel::Portable:
+            return "portable";
+        case Kernel::SSE2:
+            return "SSE2";
+        case Kernel::AVX2:
+            return "AVX2";
+    }
+    return "unknown";
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        vector<Kernel> kernels;
+        for (const Kernel kernel : {Kernel::Portable, Kernel::SSE2, Kernel::AVX2}) {
+            if (InternetChecksum::supported(kernel)) {
+                kernels.push_back(kernel);
+            }
+        }
+        test_err_if(not InternetChecksum::supported(InternetChecksum::best_kernel()), "best kernel is not supported");
+
+        // the example of RFC 1071, section 3
+        for (const Kernel kernel : kernels) {
+            InternetChecksum sum{0, kernel};
+            sum.add(string{"\x00\x01\xf2\x03\xf4\xf5\xf6\xf7", 8});
+            test_err_if(sum.value() != 0x220d, kernel_name(kernel) + " kernel got the RFC 1071 example wrong");
+        }
+
+        // all kernels agree with the reference, however the data is split into calls to add()
+        uniform_int_distribution<size_t> size_dist{0, 3000};
+        for (size_t round = 0; round < 2000; round++) {
+            string data(round < 200 ? round : size_dist(rd), 0);
+            // all-ones bytes exercise the carries
+            for (auto &c : data) {
+                c = round % 5 == 0 ? static_cast<char>(0xff) : static_cast<char>(rd());
+            }
+            const uint32_t initial_sum = round % 2 == 0 ? 0 : rd();
+            const uint16_t expected = reference_checksum(initial_sum, data);
+
+            vector<size_t> cuts{0, data.size()};
+            const size_t n_cuts = uniform_int_distribution<size_t>{0, 5}(rd);
+            for (size_t i = 0; i < n_cuts; i++) {
+                cuts.push_back(uniform_int_distribution<size_t>{0, data.size()}(rd));
+            }
+            sort(cuts.begin(), cuts.end());
+
+            for (const Kernel kernel : kernels) {
+                InternetChecksum whole{initial_sum, kernel};
+                whole.add(data);
+                test_err_if(whole.value() != expected,
+                            kernel_name(kernel) + " kernel got the wrong checksum for " + to_string(data.size()) +
+                                " bytes");
+
+                InternetChecksum pieces{initial_sum, kernel};
+                for (size_t i = 0; i + 1 < cuts.size(); i++) {
+                    pieces.add(string_view{data}.substr(cuts[i], cuts[i + 1] - cuts[i]));
+                }
+                test_err_if(pieces.value() != expected,
+                            kernel_name(kernel) + " kernel got the wrong checksum for " + to_string(data.size()) +
+                                " bytes added in " + to_string(cuts.size() - 1) + " pieces");
+            }
+        }
+
+        // copying while summing gives the same sum, and an exact copy, from any offset
+        for (size_t round = 0; round < 500; round++) {
+            string data(uniform_int_distribution<size_t>{0, 3000}(rd), 0);
+            for (auto &c : data) {
+                c = static_cast<char>(rd());
+            }
+            // misalign the source and the destination differently
+            const string_view source = string_view{data}.substr(min<size_t>(data.size(), round % 4));
+            const size_t to = round % 8;
+            for (const Kernel kernel : kernels) {
+                InternetChecksum summed{0, kernel};
+                summed.add(source);
+                InternetChecksum copied{0, kernel};
+                string dest(source.size() + to, 0);
+                copied.add_copy(dest.data() + to, source);
+                test_err_if(copied.value() != summed.value(),
+                            kernel_name(kernel) + " kernel got a different sum when copying " +
+                                to_string(source.size()) + " bytes");
+                test_err_if(string_view{dest}.substr(to) != source,
+                            kernel_name(kernel) + " kernel made a bad copy of " + to_string(source.size()) + " bytes");
+            }
+        }
+
+        // a segment whose payload was summed once still serializes with correct checksums
+        for (size_t round = 0; round < 100; round++) {
+            string data(uniform_int_distribution<size_t>{1, 3000}(rd), 0);
+            for (auto &c : data) {
+                c = static_cast<char>(rd());
+            }
+            const uint32_t pseudo_checksum = rd() & 0xffff;
+            const auto parses = [&](const TCPSegment &seg) {
+                TCPSegment parsed;
+                return parsed.parse(seg.serialize(pseudo_checksum).concatenate(), pseudo_checksum) ==
+                           ParseResult::NoError and
+                       parsed.header().ackno == seg.header().ackno and parsed.header().sack == seg.header().sack and
+                       parsed.payload().str() == seg.payload().str();
+            };
+
+            TCPSegment seg;
+            seg.header().seqno = WrappingInt32(rd());
+            seg.payload() = string(data);
+            seg.sum_payload();
+            test_err_if(not parses(seg), "summed segment did not parse");
+
+            // header changes, as TCPConnection makes them
+            TCPSegment copy = seg;
+            copy.header().ack = true;
+            copy.header().ackno = WrappingInt32(rd());
+            copy.header().win = rd() & 0xffff;
+            copy.header().sack = {{WrappingInt32(rd()), WrappingInt32(rd())}};
+            test_err_if(not parses(copy), "summed segment with a new header did not parse");
+
+            // payload changes, as a partial ACK or a new payload of the same size make them
+            copy.payload().remove_prefix(data.size() / 2);
+            test_err_if(not parses(copy), "summed segment with a trimmed payload did not parse");
+            data.back()++;
+            copy.payload() = string(data);
+            test_err_if(not parses(copy), "summed segment with a new payload did not parse");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return err_num;
+    }
+
+    return EXIT_SUCCESS;
+}
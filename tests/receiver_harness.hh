@@ -13,6 +13,7 @@
 #include <optional>
 #include <sstream>
 #include <string>
+#include <vector>
 
 struct ReceiverTestStep {
     virtual std::string to_string() const { return "ReceiverTestStep"; }
@@ -84,6 +85,32 @@ struct ExpectWindow : public ReceiverExpectation {
     }
 };
 
+struct ExpectSackBlocks : public ReceiverExpectation {
+    std::vector<TCPHeader::SACKBlock> _blocks;
+
+    ExpectSackBlocks(std::vector<TCPHeader::SACKBlock> blocks) : _blocks(std::move(blocks)) {}
+
+    static std::string blocks_string(const std::vector<TCPHeader::SACKBlock> &blocks) {
+        std::ostringstream ss;
+        ss << "[";
+        for (const auto &block : blocks) {
+            ss << " " << block.left.raw_value() << "-" << block.right.raw_value();
+        }
+        ss << " ]";
+        return ss.str();
+    }
+
+    std::string description() const { return "SACK blocks " + blocks_string(_blocks); }
+
+    void execute(TCPReceiver &receiver) const {
+        const auto blocks = receiver.sack_blocks();
+        if (blocks != _blocks) {
+            throw ReceiverExpectationViolation("The TCPReceiver reported SACK blocks `" + blocks_string(blocks) +
+                                               "`, but they were expected to be `" + blocks_string(_blocks) + "`");
+        }
+    }
+};
+
 struct ExpectUnassembledBytes : public ReceiverExpectation {
     size_t _n_bytes;
 
@@ -298,10 +325,13 @@ class TCPReceiverTestHarness {
     std::vector<std::string> steps_executed;
 
   public:
-    TCPReceiverTestHarness(size_t capacity) : receiver(capacity), steps_executed() {
+    TCPReceiverTestHarness(size_t capacity,
+                           StreamReassembler::StorageMode storage = StreamReassembler::StorageMode::Fragments)
+        : receiver(capacity, storage), steps_executed() {
         std::ostringstream ss;
         ss << "Initialized with ("
-           << "capacity=" << capacity << ")";
+           << "capacity=" << capacity
+           << (storage == StreamReassembler::StorageMode::Slab ? ", slab storage" : "") << ")";
         steps_executed.emplace_back(ss.str());
     }
     void execute(const ReceiverTestStep &step) {
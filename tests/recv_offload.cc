@@ -0,0 +1,133 @@
+#include "tcp_receiver.hh"
+#include "tcp_segment.hh"
+#include "tcp_segment_coalescer.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static TCPSegment data_segment(const WrappingInt32 seqno, const string &data, const WrappingInt32 ackno) {
+    TCPSegment seg;
+    seg.header().seqno = seqno;
+    seg.header().ack = true;
+    seg.header().ackno = ackno;
+    seg.header().win = 1000;
+    seg.payload() = string(data);
+    return seg;
+}
+
+//! Push every segment through a coalescer, and return what comes out
+static vector<TCPSegment> coalesce(vector<TCPSegment> segments,
+                                   const size_t max_payload = TCPConfig::MAX_OFFLOAD_SIZE) {
+    TCPSegmentCoalescer coalescer{max_payload};
+    vector<TCPSegment> out;
+    for (auto &seg : segments) {
+        auto run = coalescer.push(move(seg));
+        if (run) {
+            out.push_back(move(run.value()));
+        }
+    }
+    auto run = coalescer.flush();
+    if (run) {
+        out.push_back(move(run.value()));
+    }
+    return out;
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        const WrappingInt32 isn(rd());
+        const WrappingInt32 ackno(rd());
+
+        // consecutive segments merge into one, with the window and FIN of the last
+        {
+            vector<TCPSegment> segments{data_segment(isn + 1, "abc", ackno),
+                                        data_segment(isn + 4, "defg", ackno),
+                                        data_segment(isn + 8, "hi", ackno)};
+            segments.back().header().win = 500;
+            segments.back().header().fin = true;
+            const auto out = coalesce(move(segments));
+            test_err_if(out.size() != 1, "consecutive segments were not merged");
+            test_err_if(out.front().header().seqno != isn + 1, "merged segment has the wrong seqno");
+            test_err_if(out.front().payload().str() != "abcdefghi", "merged segment has the wrong payload");
+            test_err_if(out.front().header().win != 500, "merged segment does not have the latest window");
+            test_err_if(not out.front().header().fin, "merged segment lost the FIN");
+        }
+
+        // runs end at a gap, a different ackno, a FIN, a segment without data, or the size limit
+        {
+            vector<TCPSegment> segments{data_segment(isn + 1, "abc", ackno),
+                                        data_segment(isn + 5, "efg", ackno),
+                                        data_segment(isn + 8, "hij", ackno + 1),
+                                        data_segment(isn + 11, "klm", ackno + 1),
+                                        data_segment(isn + 14, "", ackno + 1),
+                                        data_segment(isn + 14, "nopq", ackno + 1),
+                                        data_segment(isn + 18, "rst", ackno + 1),
+                                        data_segment(isn + 21, "uvw", ackno + 1)};
+            segments.at(6).header().fin = true;
+            const auto out = coalesce(move(segments), 6);
+            const vector<string> payloads{"abc", "efg", "hijklm", "", "nopq", "rst", "uvw"};
+            test_err_if(out.size() != payloads.size(),
+                        "got " + to_string(out.size()) + " segments, expected " + to_string(payloads.size()));
+            for (size_t i = 0; i < out.size(); i++) {
+                test_err_if(out.at(i).payload().str() != payloads.at(i),
+                            "segment " + to_string(i) + " has payload \"" + out.at(i).payload().copy() + "\"");
+            }
+        }
+
+        // different options and SYNs are never merged
+        {
+            vector<TCPSegment> segments{data_segment(isn, "abc", ackno),
+                                        data_segment(isn + 4, "def", ackno),
+                                        data_segment(isn + 7, "ghi", ackno)};
+            segments.at(0).header().syn = true;
+            segments.at(2).header().timestamps = TCPHeader::Timestamps{1, 2};
+            test_err_if(coalesce(move(segments)).size() != 3, "segments with a SYN or different options were merged");
+        }
+
+        // the receiver ends up in the same state as with the separate segments
+        {
+            TCPReceiver merged{4000}, separate{4000};
+            TCPSegment syn;
+            syn.header().seqno = isn;
+            syn.header().syn = true;
+            merged.segment_received(syn);
+            separate.segment_received(syn);
+
+            vector<TCPSegment> segments;
+            string data;
+            for (size_t i = 0; i < 10; i++) {
+                const string chunk(1 + rd() % 100, static_cast<char>('a' + i));
+                segments.push_back(data_segment(isn + static_cast<uint32_t>(1 + data.size()), chunk, ackno));
+                data += chunk;
+            }
+            segments.back().header().fin = true;
+            for (const auto &seg : segments) {
+                separate.segment_received(seg);
+            }
+            const auto out = coalesce(move(segments));
+            test_err_if(out.size() != 1, "segments were not merged");
+            merged.segment_received(out.front());
+
+            test_err_if(merged.ackno() != separate.ackno(), "merged segment left a different ackno");
+            test_err_if(merged.window_size() != separate.window_size(), "merged segment left a different window");
+            test_err_if(not merged.stream_out().input_ended(), "merged segment did not end the stream");
+            test_err_if(merged.stream_out().read(data.size()) != data, "merged segment delivered the wrong data");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return err_num;
+    }
+
+    return EXIT_SUCCESS;
+}
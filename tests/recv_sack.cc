@@ -0,0 +1,93 @@
+#include "receiver_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        for (const auto storage : {StreamReassembler::StorageMode::Fragments, StreamReassembler::StorageMode::Slab}) {
+            // Blocks appear for out-of-order data, merge as holes fill, and vanish once assembled
+            {
+                uint32_t isn = uniform_int_distribution<uint32_t>{0, UINT32_MAX}(rd);
+                TCPReceiverTestHarness test{4000, storage};
+                test.execute(SegmentArrives{}.with_syn().with_seqno(isn).with_result(SegmentArrives::Result::OK));
+                test.execute(ExpectSackBlocks{{}});
+                test.execute(SegmentArrives{}.with_seqno(isn + 3).with_data("cd"));
+                test.execute(ExpectSackBlocks{{{WrappingInt32{isn + 3}, WrappingInt32{isn + 5}}}});
+                test.execute(SegmentArrives{}.with_seqno(isn + 7).with_data("gh"));
+                test.execute(ExpectSackBlocks{{{WrappingInt32{isn + 7}, WrappingInt32{isn + 9}},
+                                               {WrappingInt32{isn + 3}, WrappingInt32{isn + 5}}}});
+                test.execute(SegmentArrives{}.with_seqno(isn + 5).with_data("ef"));
+                test.execute(ExpectSackBlocks{{{WrappingInt32{isn + 3}, WrappingInt32{isn + 9}}}});
+                test.execute(ExpectAckno{WrappingInt32{isn + 1}});
+                test.execute(SegmentArrives{}.with_seqno(isn + 1).with_data("ab"));
+                test.execute(ExpectAckno{WrappingInt32{isn + 9}});
+                test.execute(ExpectSackBlocks{{}});
+            }
+
+            // The latest block comes first, then the lowest others, up to the limit
+            {
+                uint32_t isn = uniform_int_distribution<uint32_t>{0, UINT32_MAX}(rd);
+                TCPReceiverTestHarness test{4000, storage};
+                test.execute(SegmentArrives{}.with_syn().with_seqno(isn).with_result(SegmentArrives::Result::OK));
+                for (uint32_t offset = 3; offset <= 18; offset += 3) {
+                    test.execute(SegmentArrives{}.with_seqno(isn + offset).with_data("x"));
+                }
+                test.execute(ExpectSackBlocks{{{WrappingInt32{isn + 18}, WrappingInt32{isn + 19}},
+                                               {WrappingInt32{isn + 3}, WrappingInt32{isn + 4}},
+                                               {WrappingInt32{isn + 6}, WrappingInt32{isn + 7}},
+                                               {WrappingInt32{isn + 9}, WrappingInt32{isn + 10}}}});
+                test.execute(SegmentArrives{}.with_seqno(isn + 10).with_data("x"));
+                test.execute(ExpectSackBlocks{{{WrappingInt32{isn + 9}, WrappingInt32{isn + 11}},
+                                               {WrappingInt32{isn + 3}, WrappingInt32{isn + 4}},
+                                               {WrappingInt32{isn + 6}, WrappingInt32{isn + 7}},
+                                               {WrappingInt32{isn + 12}, WrappingInt32{isn + 13}}}});
+            }
+        }
+
+        // SACK options survive serialization and parsing
+        {
+            uint32_t base = uniform_int_distribution<uint32_t>{0, UINT32_MAX}(rd);
+            TCPSegment seg;
+            seg.header().syn = true;
+            seg.header().ack = true;
+            seg.header().seqno = WrappingInt32{base};
+            seg.header().sack_permitted = true;
+            seg.header().sack = {{WrappingInt32{base + 100}, WrappingInt32{base + 200}},
+                                 {WrappingInt32{base + 300}, WrappingInt32{base + 400}}};
+            seg.payload() = string("payload");
+
+            TCPSegment parsed;
+            if (parsed.parse(seg.serialize().concatenate()) != ParseResult::NoError) {
+                throw runtime_error("failed to parse a segment with SACK options");
+            }
+            if (parsed.header().doff != 11) {
+                throw runtime_error("data offset " + to_string(parsed.header().doff) +
+                                    " for SACK options, expected 11");
+            }
+            parsed.header().doff = seg.header().doff;
+            if (not(parsed.header() == seg.header()) or parsed.payload().str() != "payload") {
+                throw runtime_error("SACK options did not round-trip:\n" + parsed.header().to_string());
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,273 @@
+#include "congestion_controller.hh"
+#include "sender_harness.hh"
+#include "test_err_if.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static constexpr uint64_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+static constexpr uint64_t INITIAL_WINDOW = 10 * MSS;
+static constexpr uint16_t WIN = 60000;
+
+//! Complete the handshake, write `n_segments` full segments, and expect the initial window of them to be sent
+static void send_initial_window(TCPSenderTestHarness &test, const WrappingInt32 isn, const size_t n_segments) {
+    test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+    test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(WIN));
+    test.execute(ExpectCongestionWindow{INITIAL_WINDOW});
+    test.execute(WriteBytes{string(n_segments * MSS, 'x')});
+    for (size_t i = 0; i < INITIAL_WINDOW / MSS; i++) {
+        test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + i * MSS));
+    }
+    test.execute(ExpectNoSegment{});
+    test.execute(ExpectBytesInFlight{INITIAL_WINDOW});
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"No congestion window by default", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(WIN));
+            test.execute(ExpectCongestionWindow{nullopt});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = CongestionController::Algorithm::Reno;
+
+            TCPSenderTestHarness test{"Slow start opens the window by one MSS per ACK", cfg};
+            send_initial_window(test, isn, 20);
+            test.execute(AckReceived{WrappingInt32{isn + 1 + MSS}}.with_win(WIN));
+            test.execute(ExpectCongestionWindow{INITIAL_WINDOW + MSS});
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + 10 * MSS));
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + 11 * MSS));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = CongestionController::Algorithm::Reno;
+
+            TCPSenderTestHarness test{"The window does not grow while it does not limit the sender", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(WIN));
+            test.execute(WriteBytes{string(2 * MSS, 'x')});
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1));
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + MSS));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + MSS}}.with_win(WIN));
+            test.execute(ExpectCongestionWindow{INITIAL_WINDOW});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 2 * MSS}}.with_win(WIN));
+            test.execute(ExpectCongestionWindow{INITIAL_WINDOW});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = CongestionController::Algorithm::Reno;
+
+            TCPSenderTestHarness test{"The receiver's window still applies", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(3 * MSS));
+            test.execute(WriteBytes{string(5 * MSS, 'x')});
+            test.execute(ExpectSegment{}.with_payload_size(MSS));
+            test.execute(ExpectSegment{}.with_payload_size(MSS));
+            test.execute(ExpectSegment{}.with_payload_size(MSS));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = CongestionController::Algorithm::NewReno;
+
+            TCPSenderTestHarness test{"NewReno fast retransmit and fast recovery", cfg};
+            send_initial_window(test, isn, 12);
+
+            // two duplicates change nothing
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(WIN));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(WIN));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectCongestionWindow{INITIAL_WINDOW});
+
+            // the third resends the oldest segment, halves ssthresh and inflates by three segments
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(WIN));
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectCongestionWindow{INITIAL_WINDOW / 2 + 3 * MSS});
+
+            // each further duplicate inflates by one segment, eventually letting new data out
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(WIN));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(WIN));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(WIN));
+            test.execute(ExpectCongestionWindow{INITIAL_WINDOW / 2 + 6 * MSS});
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + 10 * MSS));
+            test.execute(ExpectNoSegment{});
+
+            // a partial ACK resends the next hole and deflates the window
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 3 * MSS}}.with_win(WIN));
+            test.execute(ExpectCongestionWindow{INITIAL_WINDOW / 2 + 4 * MSS});
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + 3 * MSS));
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + 11 * MSS));
+            test.execute(ExpectNoSegment{});
+
+            // a full ACK ends recovery
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 12 * MSS}}.with_win(WIN));
+            test.execute(ExpectCongestionWindow{2 * MSS});
+            test.execute(ExpectBytesInFlight{0});
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = CongestionController::Algorithm::Reno;
+
+            TCPSenderTestHarness test{"Reno leaves fast recovery on a partial ACK", cfg};
+            send_initial_window(test, isn, 12);
+            for (int i = 0; i < 3; i++) {
+                test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(WIN));
+            }
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 3 * MSS}}.with_win(WIN));
+            test.execute(ExpectCongestionWindow{INITIAL_WINDOW / 2});
+            test.execute(ExpectNoSegment{});
+
+            // back in congestion avoidance, a further duplicate ACK is only counted
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 3 * MSS}}.with_win(WIN));
+            test.execute(ExpectCongestionWindow{INITIAL_WINDOW / 2});
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = CongestionController::Algorithm::NewReno;
+
+            TCPSenderTestHarness test{"An ACK in a segment with data is not a duplicate ACK", cfg};
+            send_initial_window(test, isn, 12);
+            for (int i = 0; i < 3; i++) {
+                test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(WIN).with_data());
+            }
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectCongestionWindow{INITIAL_WINDOW});
+
+            // the duplicates that follow are counted from the first
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(WIN));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(WIN));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(WIN));
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1));
+            test.execute(ExpectCongestionWindow{INITIAL_WINDOW / 2 + 3 * MSS});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            const size_t rto = uniform_int_distribution<uint16_t>{30, 10000}(rd);
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = rto;
+            cfg.congestion_control = CongestionController::Algorithm::NewReno;
+
+            TCPSenderTestHarness test{"A timeout collapses the window to one segment", cfg};
+            send_initial_window(test, isn, 12);
+            test.execute(Tick{rto});
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectCongestionWindow{MSS});
+
+            // slow start again, up to the halved threshold
+            test.execute(AckReceived{WrappingInt32{isn + 1 + MSS}}.with_win(WIN));
+            test.execute(ExpectCongestionWindow{2 * MSS});
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = CongestionController::Algorithm::Cubic;
+
+            TCPSenderTestHarness test{"CUBIC reduces the window by 30% on loss", cfg};
+            send_initial_window(test, isn, 12);
+            for (int i = 0; i < 3; i++) {
+                test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(WIN));
+            }
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1));
+            test.execute(ExpectCongestionWindow{INITIAL_WINDOW * 7 / 10 + 3 * MSS});
+        }
+
+        // Reno congestion avoidance: one MSS per window acknowledged
+        {
+            RenoController reno{MSS, true};
+            reno.on_timeout(INITIAL_WINDOW, 0);
+            while (reno.window() < reno.slow_start_threshold()) {
+                reno.on_ack(MSS, 0);
+            }
+            const uint64_t start = reno.window();
+            reno.on_ack(start - 1, 0);
+            test_err_if(reno.window() != start, "Reno grew before a full window was acknowledged");
+            reno.on_ack(1, 0);
+            test_err_if(reno.window() != start + MSS, "Reno did not grow by one MSS after a full window");
+        }
+
+        // CUBIC: concave growth back to the previous maximum, then convex growth beyond it
+        {
+            CubicController cubic{MSS};
+            while (cubic.window() < 1000 * MSS) {
+                cubic.on_ack(MSS, 0);
+            }
+            const uint64_t w_max = cubic.window();
+            cubic.on_fast_retransmit(w_max, 0);
+            cubic.on_recovery_end(w_max);
+            test_err_if(cubic.window() != w_max * 7 / 10, "CUBIC did not reduce its window to 70%");
+
+            // one window acknowledged per 100 ms round trip
+            vector<uint64_t> windows;
+            for (uint64_t now = 100; now <= 20000; now += 100) {
+                cubic.on_ack(cubic.window(), now);
+                windows.push_back(cubic.window());
+            }
+
+            // K = cbrt(W_max * (1 - beta) / C) is about 9.1 seconds for W_max = 1000 segments
+            const uint64_t at_k = windows.at(90);
+            test_err_if(at_k <= w_max * 95 / 100 or at_k >= w_max * 105 / 100,
+                        "CUBIC window was " + to_string(at_k) + " at K, expected about " + to_string(w_max));
+            test_err_if(windows.at(30) - windows.at(0) <= windows.at(60) - windows.at(30) or
+                            windows.at(60) - windows.at(30) <= windows.at(90) - windows.at(60),
+                        "CUBIC growth was not concave below the previous maximum");
+            test_err_if(windows.at(150) - windows.at(120) <= windows.at(120) - windows.at(90),
+                        "CUBIC growth was not convex above the previous maximum");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return err_num;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,149 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+//! Complete the handshake and send four 4-byte segments, "abcd" through "mnop"
+static void send_four_segments(TCPSenderTestHarness &test, const WrappingInt32 isn) {
+    test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+    test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+    for (const char *data : {"abcd", "efgh", "ijkl", "mnop"}) {
+        test.execute(WriteBytes{string(data)});
+        test.execute(ExpectSegment{}.with_data(data));
+    }
+    test.execute(ExpectBytesInFlight{16});
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = 1000;
+
+            TCPSenderTestHarness test{"Duplicate ACKs are only counted by default", cfg};
+            send_four_segments(test, isn);
+            for (int i = 0; i < 3; i++) {
+                test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            }
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1000});
+            test.execute(ExpectSegment{}.with_data("abcd").with_seqno(isn + 1));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = 1000;
+            cfg.fast_retransmit = true;
+
+            TCPSenderTestHarness test{"Three duplicate ACKs resend the oldest segment before the timer", cfg};
+            send_four_segments(test, isn);
+            test.execute(Tick{10});
+
+            // "abcd" was lost; each later segment draws a duplicate ACK
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(ExpectSegment{}.with_data("abcd").with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{16});
+
+            // it is resent only once, however many duplicates follow
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(ExpectNoSegment{});
+
+            test.execute(AckReceived{WrappingInt32{isn + 17}}.with_win(1000));
+            test.execute(ExpectBytesInFlight{0});
+            test.execute(Tick{1000});
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = 1000;
+            cfg.fast_retransmit = true;
+
+            TCPSenderTestHarness test{"A partial ACK during recovery resends the next hole", cfg};
+            send_four_segments(test, isn);
+
+            // "abcd" and "ijkl" were lost
+            for (int i = 0; i < 3; i++) {
+                test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            }
+            test.execute(ExpectSegment{}.with_data("abcd").with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+
+            test.execute(AckReceived{WrappingInt32{isn + 9}}.with_win(1000));
+            test.execute(ExpectSegment{}.with_data("ijkl").with_seqno(isn + 9));
+            test.execute(ExpectNoSegment{});
+
+            // recovery ends once everything outstanding at the loss is acknowledged
+            test.execute(AckReceived{WrappingInt32{isn + 17}}.with_win(1000));
+            test.execute(ExpectBytesInFlight{0});
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = 1000;
+            cfg.fast_retransmit = true;
+
+            TCPSenderTestHarness test{"ACKs that update the window are not duplicates", cfg};
+            send_four_segments(test, isn);
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1001));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1002));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1003));
+            test.execute(ExpectNoSegment{});
+
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1003));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1003));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1003));
+            test.execute(ExpectSegment{}.with_data("abcd").with_seqno(isn + 1));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = 1000;
+            cfg.fast_retransmit = true;
+
+            TCPSenderTestHarness test{"A timeout restarts the duplicate ACK count", cfg};
+            send_four_segments(test, isn);
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(Tick{1000});
+            test.execute(ExpectSegment{}.with_data("abcd").with_seqno(isn + 1));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(ExpectSegment{}.with_data("abcd").with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
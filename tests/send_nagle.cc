@@ -0,0 +1,70 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.nodelay = false;
+
+            TCPSenderTestHarness test{"Nagle holds small segments back while data is in flight", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+
+            // nothing is in flight, so the first small segment goes at once
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_data("abc").with_seqno(isn + 1));
+            test.execute(WriteBytes{"def"});
+            test.execute(WriteBytes{"ghi"});
+            test.execute(ExpectNoSegment{});
+
+            // the ACK releases what was written meanwhile, as one segment
+            test.execute(AckReceived{WrappingInt32{isn + 4}}.with_win(10000));
+            test.execute(ExpectSegment{}.with_data("defghi").with_seqno(isn + 4));
+            test.execute(ExpectNoSegment{});
+
+            // a full-sized segment does not wait, but the small remainder does
+            test.execute(WriteBytes{string(MSS + 5, 'x')});
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 10));
+            test.execute(ExpectNoSegment{});
+
+            // nor does the last data before a FIN
+            test.execute(Close{});
+            test.execute(ExpectSegment{}.with_payload_size(5).with_fin(true).with_seqno(isn + 10 + MSS));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"Small segments go at once by default (nodelay)", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_data("abc"));
+            test.execute(WriteBytes{"def"});
+            test.execute(ExpectSegment{}.with_data("def"));
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,172 @@
+#include "tcp_config.hh"
+#include "tcp_segment.hh"
+#include "tcp_sender.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+//! Complete the handshake of a sender with segmentation offload, and return it ready to send data
+static TCPSender connected_sender(const WrappingInt32 isn, const uint64_t window) {
+    TCPConfig cfg;
+    cfg.fixed_isn = isn;
+    cfg.segmentation_offload = true;
+    TCPSender sender{cfg};
+    sender.fill_window();
+    sender.segments_out().pop();
+    sender.ack_received(isn + 1, window);
+    return sender;
+}
+
+static string pattern(const size_t size) {
+    string data(size, 0);
+    for (size_t i = 0; i < size; i++) {
+        data[i] = static_cast<char>('a' + i % 26);
+    }
+    return data;
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // the sender builds one large segment, limited by the window
+        {
+            const WrappingInt32 isn(rd());
+            TCPSender sender = connected_sender(isn, 50000);
+            const string data = pattern(60000);
+            sender.stream_in().write(string(data));
+            sender.fill_window();
+            test_err_if(sender.segments_out().size() != 1, "sender did not build a single segment");
+            const TCPSegment &seg = sender.segments_out().front();
+            test_err_if(seg.header().seqno != isn + 1, "large segment has the wrong seqno");
+            test_err_if(seg.payload().str() != data.substr(0, 50000), "large segment has the wrong payload");
+            test_err_if(sender.bytes_in_flight() != 50000, "large segment not counted in flight");
+            sender.segments_out().pop();
+
+            // but a timeout resends only its first MSS
+            sender.tick(TCPConfig::TIMEOUT_DFLT);
+            test_err_if(sender.segments_out().size() != 1, "timeout did not resend exactly one segment");
+            test_err_if(sender.segments_out().front().header().seqno != isn + 1 or
+                            sender.segments_out().front().payload().str() != data.substr(0, MSS),
+                        "timeout did not resend the first MSS of the large segment");
+            sender.segments_out().pop();
+
+            // and an ACK for that piece leaves the next one to be resent
+            sender.ack_received(isn + 1 + MSS, 50000);
+            test_err_if(sender.bytes_in_flight() != 50000 - MSS, "acknowledged piece still counted in flight");
+            sender.tick(TCPConfig::TIMEOUT_DFLT);
+            test_err_if(sender.segments_out().size() != 1 or
+                            sender.segments_out().front().header().seqno != isn + static_cast<uint32_t>(1 + MSS) or
+                            sender.segments_out().front().payload().str() != data.substr(MSS, MSS),
+                        "timeout did not resend the second MSS of the large segment");
+        }
+
+        // an ACK inside a piece trims it, so a timeout only resends the rest of that piece
+        {
+            const WrappingInt32 isn(rd());
+            TCPSender sender = connected_sender(isn, 50000);
+            const string data = pattern(10 * MSS);
+            sender.stream_in().write(string(data));
+            sender.fill_window();
+            sender.segments_out().pop();
+            sender.ack_received(isn + static_cast<uint32_t>(1 + MSS + 100), 50000);
+            test_err_if(sender.bytes_in_flight() != 9 * MSS - 100, "partial ACK not counted");
+            sender.tick(TCPConfig::TIMEOUT_DFLT);
+            test_err_if(sender.segments_out().size() != 1, "timeout did not resend exactly one segment");
+            const TCPSegment &seg = sender.segments_out().front();
+            test_err_if(seg.header().seqno != isn + static_cast<uint32_t>(1 + MSS + 100) or
+                            seg.payload().str() != data.substr(MSS + 100, MSS - 100),
+                        "timeout resent acknowledged bytes");
+        }
+
+        // the payload is capped at MAX_OFFLOAD_SIZE
+        {
+            const WrappingInt32 isn(rd());
+            TCPConfig cfg;
+            cfg.fixed_isn = isn;
+            cfg.segmentation_offload = true;
+            cfg.send_capacity = 2 * TCPConfig::MAX_OFFLOAD_SIZE;
+            TCPSender sender{cfg};
+            sender.fill_window();
+            sender.segments_out().pop();
+            sender.ack_received(isn + 1, 2 * TCPConfig::MAX_OFFLOAD_SIZE);
+            sender.stream_in().write(pattern(TCPConfig::MAX_OFFLOAD_SIZE + 10));
+            sender.fill_window();
+            test_err_if(sender.segments_out().size() != 2, "sender did not build two segments");
+            test_err_if(sender.segments_out().front().payload().size() != TCPConfig::MAX_OFFLOAD_SIZE,
+                        "first segment was not capped at MAX_OFFLOAD_SIZE");
+            sender.segments_out().pop();
+            test_err_if(sender.segments_out().front().payload().size() != 10, "second segment has the wrong size");
+        }
+
+        // a split keeps the seqnos, the flags and the payload, and each piece has its own checksum
+        {
+            const WrappingInt32 isn(rd());
+            const string data = pattern(3 * MSS + 100);
+            TCPSegment seg;
+            seg.header().seqno = isn;
+            seg.header().syn = true;
+            seg.header().fin = true;
+            seg.header().ack = true;
+            seg.header().ackno = WrappingInt32(rd());
+            seg.header().win = 1234;
+            seg.payload() = string(data);
+
+            const vector<TCPSegment> pieces = seg.split(MSS);
+            test_err_if(pieces.size() != 4, "split made " + to_string(pieces.size()) + " pieces, expected 4");
+
+            const uint32_t pseudo_checksum = rd() & 0xffff;
+            size_t length_in_sequence_space = 0;
+            for (size_t i = 0; i < pieces.size(); i++) {
+                const TCPSegment &piece = pieces.at(i);
+                const size_t expected_size = i < 3 ? MSS : 100;
+                test_err_if(piece.payload().str() != data.substr(i * MSS, expected_size),
+                            "piece " + to_string(i) + " has the wrong payload");
+                test_err_if(piece.header().seqno != (i == 0 ? isn : isn + static_cast<uint32_t>(1 + i * MSS)),
+                            "piece " + to_string(i) + " has the wrong seqno");
+                test_err_if(piece.header().syn != (i == 0), "SYN is not only on the first piece");
+                test_err_if(piece.header().fin != (i == 3), "FIN is not only on the last piece");
+                test_err_if(not piece.header().ack or piece.header().ackno != seg.header().ackno or
+                                piece.header().win != 1234,
+                            "piece " + to_string(i) + " lost the ACK fields");
+                length_in_sequence_space += piece.length_in_sequence_space();
+
+                TCPSegment parsed;
+                test_err_if(parsed.parse(piece.serialize(pseudo_checksum).concatenate(), pseudo_checksum) !=
+                                ParseResult::NoError,
+                            "piece " + to_string(i) + " did not parse with its checksum");
+                test_err_if(not(parsed.header() == piece.header()) or parsed.payload().str() != piece.payload().str(),
+                            "piece " + to_string(i) + " did not survive serialization");
+            }
+            test_err_if(length_in_sequence_space != seg.length_in_sequence_space(),
+                        "pieces do not cover the segment's sequence space");
+        }
+
+        // a segment that already fits is left alone
+        {
+            TCPSegment seg;
+            seg.header().seqno = WrappingInt32(rd());
+            seg.payload() = pattern(MSS);
+            const vector<TCPSegment> pieces = seg.split(MSS);
+            test_err_if(pieces.size() != 1 or not(pieces.front().header() == seg.header()) or
+                            pieces.front().payload().str() != seg.payload().str(),
+                        "a segment that fits was changed by the split");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return err_num;
+    }
+
+    return EXIT_SUCCESS;
+}
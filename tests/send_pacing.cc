@@ -0,0 +1,144 @@
+#include "congestion_controller.hh"
+#include "sender_harness.hh"
+#include "test_err_if.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <string>
+
+using namespace std;
+
+static constexpr uint64_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+static constexpr uint16_t WIN = 60000;
+
+//! Feeds a BBRController one delivery rate sample per call, as a sender on a steady path would
+class PathModel {
+    uint64_t _now{0};
+    uint64_t _delivered{0};
+
+  public:
+    BBRController bbr{MSS};
+
+    void sample(const uint64_t bytes, const uint64_t interval, const uint64_t rtt, const uint64_t in_flight) {
+        _now += interval;
+        const uint64_t prior = _delivered;
+        _delivered += bytes;
+        bbr.on_rate_sample({bytes, interval, rtt, prior, _delivered, in_flight}, _now);
+    }
+
+    uint64_t now() const { return _now; }
+};
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = CongestionController::Algorithm::BBR;
+
+            TCPSenderTestHarness test{"BBR paces new segments at its bandwidth estimate", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{100});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(WIN));
+
+            // unpaced until the first bandwidth sample
+            test.execute(WriteBytes{string(20 * MSS, 'x')});
+            for (size_t i = 0; i < 10; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + i * MSS));
+            }
+            test.execute(ExpectNoSegment{});
+
+            // 10 segments delivered in 100 ms: 145.2 bytes/ms, paced at 2.885 times that in Startup
+            test.execute(Tick{100});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 10 * MSS}}.with_win(WIN));
+            test.execute(ExpectCongestionWindow{20 * MSS});
+            test.execute(ExpectNoSegment{});
+
+            test.execute(Tick{3});
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + 10 * MSS));
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{3});
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + 11 * MSS));
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{10});
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + 12 * MSS));
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + 13 * MSS));
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + 14 * MSS));
+            test.execute(ExpectNoSegment{});
+        }
+
+        // BBR's state machine on a path with 1000 bytes/ms of bandwidth and a 50 ms round trip
+        {
+            PathModel path;
+            BBRController &bbr = path.bbr;
+            test_err_if(bbr.mode() != BBRController::Mode::Startup, "BBR did not begin in Startup");
+            test_err_if(bbr.pacing_rate().has_value(), "BBR paced before it had a bandwidth sample");
+
+            // the bandwidth stops growing: three rounds later, Startup ends
+            for (int round = 0; round < 3; round++) {
+                path.sample(51000, 51, 50, 100000);
+                test_err_if(bbr.mode() != BBRController::Mode::Startup, "BBR left Startup too early");
+            }
+            path.sample(51000, 51, 50, 100000);
+            test_err_if(bbr.mode() != BBRController::Mode::Drain, "BBR did not enter Drain");
+            test_err_if(bbr.pacing_rate().value() >= 1000, "BBR did not pace below the bandwidth in Drain");
+
+            // the queue is gone once no more than a BDP is in flight
+            path.sample(51000, 51, 50, 40000);
+            test_err_if(bbr.mode() != BBRController::Mode::ProbeBW, "BBR did not enter ProbeBW");
+            test_err_if(bbr.window() != 100000, "BBR window in ProbeBW was not two BDPs");
+
+            // one gain per round-trip time
+            for (const double gain : {1.25, 0.75, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.25}) {
+                test_err_if(bbr.pacing_rate().value() != gain * 1000,
+                            "BBR paced at " + to_string(bbr.pacing_rate().value()) + " bytes/ms, expected " +
+                                to_string(gain * 1000));
+                path.sample(51000, 51, 50, 40000);
+            }
+
+            // once the 50 ms minimum is 10 seconds old, BBR probes for a new one
+            const uint64_t min_rtt_stamp = path.now();
+            while (path.now() <= min_rtt_stamp + 10000) {
+                test_err_if(bbr.mode() != BBRController::Mode::ProbeBW, "BBR left ProbeBW too early");
+                path.sample(51000, 51, 60, 100000);
+            }
+            test_err_if(bbr.mode() != BBRController::Mode::ProbeRTT, "BBR did not enter ProbeRTT");
+            test_err_if(bbr.window() != 4 * MSS, "BBR window in ProbeRTT was not four segments");
+            test_err_if(bbr.min_rtt() != 60, "BBR did not take a new round-trip estimate");
+
+            // it stays there for 200 ms once the window has drained
+            path.sample(51000, 51, 60, 4 * MSS);
+            const uint64_t drained = path.now();
+            while (path.now() < drained + 200) {
+                test_err_if(bbr.mode() != BBRController::Mode::ProbeRTT, "BBR left ProbeRTT too early");
+                path.sample(51000, 51, 60, 4 * MSS);
+            }
+            test_err_if(bbr.mode() != BBRController::Mode::ProbeBW, "BBR did not return to ProbeBW");
+            test_err_if(bbr.window() < 100000, "BBR did not restore its window after ProbeRTT");
+        }
+
+        // a first round-trip sample more than 10 seconds in does not find an expired minimum
+        {
+            PathModel path;
+            BBRController &bbr = path.bbr;
+            path.sample(0, 10001, 50, 0);
+            test_err_if(bbr.mode() != BBRController::Mode::Startup, "BBR probed for a new minimum before it had one");
+            test_err_if(bbr.min_rtt() != 50, "BBR did not take its first round-trip estimate");
+            path.sample(51000, 51, 50, 100000);
+            test_err_if(bbr.mode() != BBRController::Mode::Startup, "BBR left Startup on its first bandwidth sample");
+            test_err_if(bbr.window() <= 4 * MSS, "BBR shrank its window before it had a bandwidth estimate");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return err_num;
+    }
+
+    return EXIT_SUCCESS;
+}
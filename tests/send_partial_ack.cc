@@ -0,0 +1,64 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = 100;
+
+            TCPSenderTestHarness test{"A partial ACK trims the segment before it is resent", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(WriteBytes{"abcdefgh"});
+            test.execute(ExpectSegment{}.with_data("abcdefgh").with_seqno(isn + 1));
+            test.execute(AckReceived{WrappingInt32{isn + 4}}.with_win(1000));
+            test.execute(ExpectBytesInFlight{5});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{100});
+            test.execute(ExpectSegment{}.with_data("defgh").with_seqno(isn + 4));
+            test.execute(AckReceived{WrappingInt32{isn + 7}}.with_win(1000));
+            test.execute(ExpectBytesInFlight{2});
+            test.execute(Tick{200});
+            test.execute(ExpectSegment{}.with_data("gh").with_seqno(isn + 7));
+            test.execute(AckReceived{WrappingInt32{isn + 9}}.with_win(1000));
+            test.execute(ExpectBytesInFlight{0});
+            test.execute(Tick{1000});
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"A partial ACK gives an RTT sample", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{40});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(ExpectRTTEstimate{40, 20});
+            test.execute(WriteBytes{"abcdef"});
+            test.execute(ExpectSegment{}.with_data("abcdef"));
+            test.execute(Tick{40});
+            test.execute(AckReceived{WrappingInt32{isn + 4}}.with_win(1000));
+            test.execute(ExpectRTTEstimate{40, 15});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
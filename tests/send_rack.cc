@@ -0,0 +1,142 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.rack = true;
+
+            TCPSenderTestHarness test{"A tail loss is probed two SRTTs after the last ACK", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{40});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(ExpectRTTEstimate{40, 20});
+
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_data("abc").with_seqno(isn + 1));
+            test.execute(WriteBytes{"def"});
+            test.execute(ExpectSegment{}.with_data("def").with_seqno(isn + 4));
+            test.execute(Tick{79});
+            test.execute(ExpectNoSegment{});
+
+            // the probe resends the last segment, and the retransmission timer restarts from it
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_data("def").with_seqno(isn + 4));
+            test.execute(Tick{999});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_data("abc").with_seqno(isn + 1));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.rack = true;
+
+            TCPSenderTestHarness test{"A lone segment's probe allows for a delayed ACK", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{40});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_data("abc").with_seqno(isn + 1));
+            test.execute(Tick{279});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_data("abc").with_seqno(isn + 1));
+
+            // only one probe until an ACK answers it
+            test.execute(Tick{500});
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 4}}.with_win(1000));
+            test.execute(WriteBytes{"def"});
+            test.execute(ExpectSegment{}.with_data("def").with_seqno(isn + 4));
+            test.execute(Tick{400});
+            test.execute(ExpectSegment{}.with_data("def").with_seqno(isn + 4));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.rack = true;
+
+            TCPSenderTestHarness test{"RACK resends a hole once the reordering window has passed", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{40});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_data("abc").with_seqno(isn + 1));
+            test.execute(WriteBytes{"def"});
+            test.execute(ExpectSegment{}.with_data("def").with_seqno(isn + 4));
+            test.execute(WriteBytes{"ghi"});
+            test.execute(ExpectSegment{}.with_data("ghi").with_seqno(isn + 7));
+
+            // a single SACK is enough: "def" arrived 30 ms after it was sent, the same time as "abc",
+            // so "abc" is lost unless it arrives within a quarter of the minimum RTT (30 ms) more
+            test.execute(Tick{30});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000).with_sack(isn + 4, isn + 7));
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{6});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_data("abc").with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+
+            // "ghi" was sent at the same time as "def", but after it in sequence
+            test.execute(AckReceived{WrappingInt32{isn + 7}}.with_win(1000));
+            test.execute(ExpectBytesInFlight{3});
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.rack = true;
+
+            TCPSenderTestHarness test{"RACK finds a lost retransmission", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{40});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_data("abc").with_seqno(isn + 1));
+            test.execute(WriteBytes{"def"});
+            test.execute(ExpectSegment{}.with_data("def").with_seqno(isn + 4));
+            test.execute(Tick{40});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000).with_sack(isn + 4, isn + 7));
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{10});
+            test.execute(ExpectSegment{}.with_data("abc").with_seqno(isn + 1));
+
+            // new data sent after the retransmission is delivered first, so it was lost too
+            test.execute(WriteBytes{"ghi"});
+            test.execute(ExpectSegment{}.with_data("ghi").with_seqno(isn + 7));
+            test.execute(Tick{40});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000).with_sack(isn + 4, isn + 10));
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{10});
+            test.execute(ExpectSegment{}.with_data("abc").with_seqno(isn + 1));
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
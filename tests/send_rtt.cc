@@ -0,0 +1,188 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = 1000;
+
+            TCPSenderTestHarness test{"RTT is measured, but the RTO is fixed by default", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(ExpectRTTEstimate{nullopt, nullopt});
+            test.execute(Tick{40});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(ExpectRTTEstimate{40, 20});
+            test.execute(ExpectRetransmissionTimeout{1000});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = 1000;
+            cfg.adaptive_rto = true;
+            cfg.rto_min = 10;
+
+            TCPSenderTestHarness test{"The first RTT sample sets the RTO", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(ExpectRetransmissionTimeout{1000});
+            test.execute(Tick{40});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(ExpectRTTEstimate{40, 20});
+            test.execute(ExpectRetransmissionTimeout{120});
+
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_data("abc"));
+            test.execute(Tick{119});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_data("abc"));
+            test.execute(ExpectRetransmissionTimeout{240});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.adaptive_rto = true;
+            cfg.rto_min = 10;
+
+            TCPSenderTestHarness test{"Later RTT samples are smoothed", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{40});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_data("abc"));
+            test.execute(Tick{20});
+            test.execute(AckReceived{WrappingInt32{isn + 4}}.with_win(1000));
+            test.execute(ExpectRTTEstimate{37.5, 20});
+            test.execute(ExpectRetransmissionTimeout{118});
+
+            test.execute(WriteBytes{"def"});
+            test.execute(ExpectSegment{}.with_data("def"));
+            test.execute(Tick{60});
+            test.execute(AckReceived{WrappingInt32{isn + 7}}.with_win(1000));
+            test.execute(ExpectRTTEstimate{40.3125, 20.625});
+            test.execute(ExpectRetransmissionTimeout{123});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.adaptive_rto = true;
+            cfg.rto_min = 10;
+
+            TCPSenderTestHarness test{"Retransmitted segments give no RTT sample (Karn's algorithm)", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{40});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(ExpectRetransmissionTimeout{120});
+
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_data("abc"));
+            test.execute(Tick{120});
+            test.execute(ExpectSegment{}.with_data("abc"));
+            test.execute(Tick{5});
+            test.execute(AckReceived{WrappingInt32{isn + 4}}.with_win(1000));
+            test.execute(ExpectRTTEstimate{40, 20});
+
+            // the backed-off RTO stays until an RTT is measured
+            test.execute(ExpectRetransmissionTimeout{240});
+            test.execute(WriteBytes{"def"});
+            test.execute(ExpectSegment{}.with_data("def"));
+            test.execute(Tick{239});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_data("def"));
+            test.execute(Tick{10});
+            test.execute(AckReceived{WrappingInt32{isn + 7}}.with_win(1000));
+            test.execute(ExpectRetransmissionTimeout{480});
+
+            test.execute(WriteBytes{"ghi"});
+            test.execute(ExpectSegment{}.with_data("ghi"));
+            test.execute(Tick{30});
+            test.execute(AckReceived{WrappingInt32{isn + 10}}.with_win(1000));
+            test.execute(ExpectRTTEstimate{38.75, 17.5});
+            test.execute(ExpectRetransmissionTimeout{109});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.adaptive_rto = true;
+            cfg.rto_min = 10;
+
+            TCPSenderTestHarness test{"Echoed timestamps measure retransmitted segments too", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{40});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000).with_tsecr(0));
+            test.execute(ExpectRTTEstimate{40, 20});
+            test.execute(ExpectRetransmissionTimeout{120});
+
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_data("abc"));
+            test.execute(Tick{120});
+            test.execute(ExpectSegment{}.with_data("abc"));
+            test.execute(Tick{5});
+
+            // the echo of the retransmission's timestamp shows which transmission was acknowledged
+            test.execute(AckReceived{WrappingInt32{isn + 4}}.with_win(1000).with_tsecr(160));
+            test.execute(ExpectRTTEstimate{35.625, 23.75});
+            test.execute(ExpectRetransmissionTimeout{131});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.adaptive_rto = true;
+            cfg.rto_min = 200;
+            cfg.rto_max = 500;
+
+            TCPSenderTestHarness test{"The RTO stays within its bounds", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{1});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(ExpectRTTEstimate{1, 0.5});
+            test.execute(ExpectRetransmissionTimeout{200});
+
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_data("abc"));
+            test.execute(Tick{199});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_data("abc"));
+            test.execute(Tick{400});
+            test.execute(ExpectSegment{}.with_data("abc"));
+            test.execute(ExpectRetransmissionTimeout{500});
+            test.execute(Tick{499});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_data("abc"));
+            test.execute(ExpectRetransmissionTimeout{500});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
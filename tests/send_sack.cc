@@ -0,0 +1,156 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            const size_t rto = uniform_int_distribution<uint16_t>{30, 10000}(rd);
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = rto;
+
+            TCPSenderTestHarness test{"Hole resent once three segments above it are SACKed", cfg};
+
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            for (const string data : {"aaaaa", "bbbbb", "ccccc", "ddddd", "eeeee"}) {
+                test.execute(WriteBytes(string(data)));
+                test.execute(ExpectSegment{}.with_data(data));
+            }
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000).with_sack(isn + 6, isn + 11));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000).with_sack(isn + 6, isn + 16));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000).with_sack(isn + 6, isn + 21));
+            test.execute(ExpectSegment{}.with_data("aaaaa").with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000).with_sack(isn + 6, isn + 21));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{25});
+            test.execute(AckReceived{WrappingInt32{isn + 21}}.with_win(1000));
+            test.execute(ExpectBytesInFlight{5});
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            const size_t rto = uniform_int_distribution<uint16_t>{30, 10000}(rd);
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = rto;
+
+            TCPSenderTestHarness test{"Only the missing segments are resent, lowest first", cfg};
+
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            for (const string data : {"aaaaa", "bbbbb", "ccccc", "ddddd", "eeeee", "fffff", "ggggg"}) {
+                test.execute(WriteBytes(string(data)));
+                test.execute(ExpectSegment{}.with_data(data));
+            }
+            test.execute(AckReceived{WrappingInt32{isn + 6}}
+                             .with_win(1000)
+                             .with_sack(isn + 16, isn + 26)
+                             .with_sack(isn + 31, isn + 36));
+            test.execute(ExpectSegment{}.with_data("bbbbb").with_seqno(isn + 6));
+            test.execute(ExpectSegment{}.with_data("ccccc").with_seqno(isn + 11));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            const size_t rto = uniform_int_distribution<uint16_t>{30, 10000}(rd);
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = rto;
+
+            TCPSenderTestHarness test{"Timeout resends the front and forgets the SACK scoreboard", cfg};
+
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            for (const string data : {"aaaaa", "bbbbb", "ccccc", "ddddd"}) {
+                test.execute(WriteBytes(string(data)));
+                test.execute(ExpectSegment{}.with_data(data));
+            }
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000).with_sack(isn + 6, isn + 21));
+            test.execute(ExpectSegment{}.with_data("aaaaa").with_seqno(isn + 1));
+            test.execute(Tick{rto});
+            test.execute(ExpectSegment{}.with_data("aaaaa").with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000).with_sack(isn + 6, isn + 21));
+            test.execute(ExpectSegment{}.with_data("aaaaa").with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            const size_t rto = uniform_int_distribution<uint16_t>{30, 10000}(rd);
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = rto;
+
+            TCPSenderTestHarness test{"Bytes SACKed before a timeout are delivered only once", cfg};
+
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(ExpectBytesDelivered{0});
+            for (const string data : {"aaaaa", "bbbbb", "ccccc", "ddddd"}) {
+                test.execute(WriteBytes(string(data)));
+                test.execute(ExpectSegment{}.with_data(data));
+            }
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000).with_sack(isn + 6, isn + 21));
+            test.execute(ExpectBytesDelivered{15});
+            test.execute(Tick{rto});
+            test.execute(ExpectSegment{}.with_data("aaaaa").with_seqno(isn + 1));
+
+            // SACKed again, then acknowledged in part and in full: only "aaaaa" is new
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000).with_sack(isn + 6, isn + 21));
+            test.execute(ExpectBytesDelivered{15});
+            test.execute(AckReceived{WrappingInt32{isn + 3}}.with_win(1000).with_sack(isn + 6, isn + 21));
+            test.execute(ExpectBytesDelivered{17});
+            test.execute(AckReceived{WrappingInt32{isn + 8}}.with_win(1000).with_sack(isn + 11, isn + 21));
+            test.execute(ExpectBytesDelivered{20});
+            test.execute(AckReceived{WrappingInt32{isn + 21}}.with_win(1000));
+            test.execute(ExpectBytesDelivered{20});
+            test.execute(ExpectBytesInFlight{0});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            const size_t rto = uniform_int_distribution<uint16_t>{30, 10000}(rd);
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = rto;
+
+            TCPSenderTestHarness test{"SACK blocks outside the outstanding data are ignored", cfg};
+
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            for (const string data : {"aaaaa", "bbbbb", "ccccc", "ddddd"}) {
+                test.execute(WriteBytes(string(data)));
+                test.execute(ExpectSegment{}.with_data(data));
+            }
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000).with_sack(isn + 6, isn + 100));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000).with_sack(isn + 21, isn + 6));
+            test.execute(ExpectNoSegment{});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -99,6 +99,90 @@ struct ExpectBytesInFlight : public SenderExpectation {
     }
 };
 
+struct ExpectBytesDelivered : public SenderExpectation {
+    uint64_t _n_bytes;
+
+    ExpectBytesDelivered(uint64_t n_bytes) : _n_bytes(n_bytes) {}
+    std::string description() const { return std::to_string(_n_bytes) + " bytes delivered"; }
+
+    void execute(TCPSender &sender, std::queue<TCPSegment> &) const {
+        if (sender.bytes_delivered() != _n_bytes) {
+            std::ostringstream ss;
+            ss << "The TCPSender reported " << sender.bytes_delivered()
+               << " bytes delivered, but there were expected to be " << _n_bytes << " bytes delivered";
+            throw SenderExpectationViolation(ss.str());
+        }
+    }
+};
+
+struct ExpectCongestionWindow : public SenderExpectation {
+    std::optional<uint64_t> _cwnd;
+
+    ExpectCongestionWindow(std::optional<uint64_t> cwnd) : _cwnd(cwnd) {}
+    std::string description() const {
+        return _cwnd.has_value() ? "congestion window of " + std::to_string(_cwnd.value()) + " bytes"
+                                 : "no congestion window";
+    }
+
+    void execute(TCPSender &sender, std::queue<TCPSegment> &) const {
+        if (sender.congestion_window() != _cwnd) {
+            std::ostringstream ss;
+            ss << "The TCPSender reported ";
+            if (sender.congestion_window().has_value()) {
+                ss << "a congestion window of " << sender.congestion_window().value() << " bytes";
+            } else {
+                ss << "no congestion window";
+            }
+            ss << ", but it was expected to have " << description();
+            throw SenderExpectationViolation(ss.str());
+        }
+    }
+};
+
+struct ExpectRTTEstimate : public SenderExpectation {
+    std::optional<double> _srtt;
+    std::optional<double> _rttvar;
+
+    ExpectRTTEstimate(std::optional<double> srtt, std::optional<double> rttvar) : _srtt(srtt), _rttvar(rttvar) {}
+    std::string description() const {
+        if (not _srtt.has_value()) {
+            return "no RTT estimate";
+        }
+        return "SRTT " + std::to_string(_srtt.value()) + " ms and RTTVAR " + std::to_string(_rttvar.value()) + " ms";
+    }
+
+    void execute(TCPSender &sender, std::queue<TCPSegment> &) const {
+        if (sender.smoothed_rtt() != _srtt or sender.rtt_variation() != _rttvar) {
+            std::ostringstream ss;
+            ss << "The TCPSender reported ";
+            if (sender.smoothed_rtt().has_value()) {
+                ss << "SRTT " << sender.smoothed_rtt().value() << " ms and RTTVAR " << sender.rtt_variation().value()
+                   << " ms";
+            } else {
+                ss << "no RTT estimate";
+            }
+            ss << ", but it was expected to have " << description();
+            throw SenderExpectationViolation(ss.str());
+        }
+    }
+};
+
+struct ExpectRetransmissionTimeout : public SenderExpectation {
+    unsigned int _rto;
+
+    ExpectRetransmissionTimeout(unsigned int rto) : _rto(rto) {}
+    std::string description() const { return "retransmission timeout of " + std::to_string(_rto) + " ms"; }
+
+    void execute(TCPSender &sender, std::queue<TCPSegment> &) const {
+        if (sender.retransmission_timeout() != _rto) {
+            std::ostringstream ss;
+            ss << "The TCPSender reported a retransmission timeout of " << sender.retransmission_timeout()
+               << " ms, but it was expected to be " << _rto << " ms";
+            throw SenderExpectationViolation(ss.str());
+        }
+    }
+};
+
 struct ExpectNoSegment : public SenderExpectation {
     ExpectNoSegment() {}
     std::string description() const { return "no (more) segments"; }
@@ -191,11 +275,23 @@ struct Tick : public SenderAction {
 struct AckReceived : public SenderAction {
     WrappingInt32 _ackno;
     std::optional<uint16_t> _window_advertisement{};
+    std::vector<TCPHeader::SACKBlock> _sack{};
+    bool _with_data{false};
+    std::optional<uint32_t> _tsecr{};
 
     AckReceived(WrappingInt32 ackno) : _ackno(ackno) {}
     std::string description() const {
         std::ostringstream ss;
         ss << "ack " << _ackno.raw_value() << " winsize " << _window_advertisement.value_or(DEFAULT_TEST_WINDOW);
+        for (const auto &block : _sack) {
+            ss << " sack " << block.left.raw_value() << "-" << block.right.raw_value();
+        }
+        if (_with_data) {
+            ss << " with data";
+        }
+        if (_tsecr.has_value()) {
+            ss << " tsecr " << _tsecr.value();
+        }
         return ss.str();
     }
 
@@ -204,8 +300,25 @@ struct AckReceived : public SenderAction {
         return *this;
     }
 
+    AckReceived &with_sack(WrappingInt32 left, WrappingInt32 right) {
+        _sack.push_back({left, right});
+        return *this;
+    }
+
+    //! The ACK arrives in a segment that carries data, so it is never a duplicate ACK
+    AckReceived &with_data() {
+        _with_data = true;
+        return *this;
+    }
+
+    AckReceived &with_tsecr(uint32_t tsecr) {
+        _tsecr.emplace(tsecr);
+        return *this;
+    }
+
     void execute(TCPSender &sender, std::queue<TCPSegment> &) const {
-        sender.ack_received(_ackno, _window_advertisement.value_or(DEFAULT_TEST_WINDOW));
+        sender.ack_received(
+            _ackno, _window_advertisement.value_or(DEFAULT_TEST_WINDOW), _sack, not _with_data, _tsecr);
         sender.fill_window();
     }
 };
@@ -394,7 +507,7 @@ class TCPSenderTestHarness {
   public:
     TCPSenderTestHarness(const std::string &name_, TCPConfig config)
         : outbound_segments()
-        , sender(config.send_capacity, config.rt_timeout, config.fixed_isn)
+        , sender(config)
         , steps_executed()
         , name(name_) {
         sender.fill_window();
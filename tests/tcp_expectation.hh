@@ -121,6 +121,8 @@ struct ExpectSegment : public TCPExpectation {
     std::optional<WrappingInt32> seqno{};
     std::optional<WrappingInt32> ackno{};
     std::optional<uint16_t> win{};
+    std::optional<std::optional<uint8_t>> wscale{};
+    std::optional<std::optional<TCPHeader::Timestamps>> timestamps{};
     std::optional<size_t> payload_size{};
     std::optional<std::string> data{};
 
@@ -171,6 +173,30 @@ struct ExpectSegment : public TCPExpectation {
         return *this;
     }
 
+    ExpectSegment &with_wscale(std::optional<uint8_t> wscale_) {
+        wscale = wscale_;
+        return *this;
+    }
+
+    static std::string wscale_string(const std::optional<uint8_t> wscale_) {
+        return wscale_.has_value() ? std::to_string(wscale_.value()) : "none";
+    }
+
+    ExpectSegment &with_timestamps(std::optional<TCPHeader::Timestamps> timestamps_) {
+        timestamps = timestamps_;
+        return *this;
+    }
+
+    ExpectSegment &with_timestamps(uint32_t tsval, uint32_t tsecr) {
+        return with_timestamps(TCPHeader::Timestamps{tsval, tsecr});
+    }
+
+    static std::string timestamps_string(const std::optional<TCPHeader::Timestamps> timestamps_) {
+        return timestamps_.has_value()
+                   ? std::to_string(timestamps_->tsval) + "/" + std::to_string(timestamps_->tsecr)
+                   : "none";
+    }
+
     ExpectSegment &with_payload_size(size_t payload_size_) {
         payload_size = payload_size_;
         return *this;
@@ -202,6 +228,12 @@ struct ExpectSegment : public TCPExpectation {
         if (win.has_value()) {
             o << "win=" << win.value() << ",";
         }
+        if (wscale.has_value()) {
+            o << "wscale=" << wscale_string(wscale.value()) << ",";
+        }
+        if (timestamps.has_value()) {
+            o << "ts=" << timestamps_string(timestamps.value()) << ",";
+        }
         if (seqno.has_value()) {
             o << "seqno=" << seqno.value() << ",";
         }
@@ -248,6 +280,14 @@ struct ExpectSegment : public TCPExpectation {
         if (win.has_value() and seg.header().win != win.value()) {
             throw SegmentExpectationViolation::violated_field("win", win.value(), seg.header().win);
         }
+        if (wscale.has_value() and seg.header().wscale != wscale.value()) {
+            throw SegmentExpectationViolation::violated_field(
+                "wscale", wscale_string(wscale.value()), wscale_string(seg.header().wscale));
+        }
+        if (timestamps.has_value() and seg.header().timestamps != timestamps.value()) {
+            throw SegmentExpectationViolation::violated_field(
+                "ts", timestamps_string(timestamps.value()), timestamps_string(seg.header().timestamps));
+        }
         if (payload_size.has_value() and seg.payload().size() != payload_size.value()) {
             throw SegmentExpectationViolation::violated_field(
                 "payload_size", payload_size.value(), seg.payload().size());
@@ -390,6 +430,8 @@ struct SendSegment : public TCPAction {
     WrappingInt32 seqno{0};
     WrappingInt32 ackno{0};
     uint16_t win{0};
+    std::optional<uint8_t> wscale{};
+    std::optional<TCPHeader::Timestamps> timestamps{};
     size_t payload_size{0};
     std::string data{};
 
@@ -403,6 +445,8 @@ struct SendSegment : public TCPAction {
         seqno = seg.header().seqno;
         ackno = seg.header().ackno;
         win = seg.header().win;
+        wscale = seg.header().wscale;
+        timestamps = seg.header().timestamps;
         data = seg.payload();
     }
 
@@ -445,6 +489,16 @@ struct SendSegment : public TCPAction {
         return *this;
     }
 
+    SendSegment &with_wscale(uint8_t wscale_) {
+        wscale = wscale_;
+        return *this;
+    }
+
+    SendSegment &with_timestamps(uint32_t tsval, uint32_t tsecr) {
+        timestamps = TCPHeader::Timestamps{tsval, tsecr};
+        return *this;
+    }
+
     SendSegment &with_payload_size(size_t payload_size_) {
         payload_size = payload_size_;
         return *this;
@@ -466,6 +520,8 @@ struct SendSegment : public TCPAction {
         data_hdr.ackno = ackno;
         data_hdr.seqno = seqno;
         data_hdr.win = win;
+        data_hdr.wscale = wscale;
+        data_hdr.timestamps = timestamps;
         return data_seg;
     }
 
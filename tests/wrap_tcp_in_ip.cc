@@ -0,0 +1,78 @@
+#include "ipv4_datagram.hh"
+#include "parser.hh"
+#include "tcp_header.hh"
+#include "tcp_over_ip.hh"
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // one adapter wraps, and the other, at the far end, unwraps
+        TCPOverIPv4Adapter local;
+        local.config_mut().source = {"10.0.0.1", 1234};
+        local.config_mut().destination = {"10.0.0.2", 5678};
+        TCPOverIPv4Adapter remote;
+        remote.config_mut().source = {"10.0.0.2", 5678};
+        remote.config_mut().destination = {"10.0.0.1", 1234};
+
+        // test 1: a segment without options
+        {
+            TCPSegment seg;
+            seg.header().seqno = WrappingInt32(rd());
+            seg.payload() = string(1000, 'x');
+            InternetDatagram dgram = local.wrap_tcp_in_ip(seg);
+            test_err_if(dgram.header().len != 20 + 20 + 1000, "test 1 failed: wrong datagram length");
+
+            InternetDatagram parsed;
+            test_err_if(parsed.parse(dgram.serialize().concatenate()) != ParseResult::NoError,
+                        "test 1 failed: datagram did not parse");
+            const optional<TCPSegment> unwrapped = remote.unwrap_tcp_in_ip(parsed);
+            test_err_if(not unwrapped.has_value(), "test 1 failed: segment did not unwrap");
+            test_err_if(unwrapped->payload().str() != seg.payload().str(), "test 1 failed: wrong payload");
+        }
+
+        // test 2: SACK options grow the TCP header beyond `doff`, and the datagram length with it
+        {
+            TCPSegment seg;
+            seg.header().seqno = WrappingInt32(rd());
+            seg.header().ack = true;
+            seg.header().ackno = WrappingInt32(rd());
+            seg.header().sack_permitted = true;
+            for (size_t i = 0; i < 3; i++) {
+                seg.header().sack.push_back({WrappingInt32(rd()), WrappingInt32(rd())});
+            }
+            seg.payload() = string(1000, 'y');
+            InternetDatagram dgram = local.wrap_tcp_in_ip(seg);
+            const size_t tcp_header_length = seg.header().serialize().size();
+            test_err_if(tcp_header_length <= TCPHeader::LENGTH, "test 2 internal error: no options serialized");
+            test_err_if(dgram.header().len != 20 + tcp_header_length + 1000, "test 2 failed: wrong datagram length");
+
+            InternetDatagram parsed;
+            test_err_if(parsed.parse(dgram.serialize().concatenate()) != ParseResult::NoError,
+                        "test 2 failed: datagram did not parse");
+            const optional<TCPSegment> unwrapped = remote.unwrap_tcp_in_ip(parsed);
+            test_err_if(not unwrapped.has_value(), "test 2 failed: segment did not unwrap");
+            test_err_if(unwrapped->header().sack != seg.header().sack or not unwrapped->header().sack_permitted,
+                        "test 2 failed: options did not survive");
+            test_err_if(unwrapped->payload().str() != seg.payload().str(), "test 2 failed: wrong payload");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return err_num;
+    }
+
+    return EXIT_SUCCESS;
+}